@@ -0,0 +1,92 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Collects frame times (in milliseconds) and summarizes them as mean and percentiles.
+class FrameStats
+{
+public:
+	std::vector<double> samples;
+
+	void addSample(double ms)
+	{
+		samples.push_back(ms);
+	}
+
+	double mean() const
+	{
+		if (samples.empty())
+			return 0.0;
+		double sum = 0.0;
+		for (double s : samples)
+			sum += s;
+		return sum / samples.size();
+	}
+
+	// nearest-rank percentile, p in [0, 100]
+	double percentile(double p) const
+	{
+		if (samples.empty())
+			return 0.0;
+		std::vector<double> sorted(samples);
+		std::sort(sorted.begin(), sorted.end());
+		size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+		if (rank > 0)
+			rank--;
+		return sorted[std::min(rank, sorted.size() - 1)];
+	}
+
+	// prints a one line summary to the given stream
+	void print(std::ostream &out, const std::string &label) const
+	{
+		out << label << ": " << samples.size() << " frames"
+			<< " | mean " << mean() << " ms"
+			<< " | p50 " << percentile(50.0) << " ms"
+			<< " | p95 " << percentile(95.0) << " ms"
+			<< " | p99 " << percentile(99.0) << " ms" << std::endl;
+	}
+
+	// writes the summary and the raw samples as a JSON object; `pose` names the golden pose the samples belong to
+	bool writeJson(const std::string &path, const std::string &renderer, const std::string &pose = std::string()) const
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			std::cout << "ERROR::BENCHMARK::CANNOT_WRITE " << path << std::endl;
+			return false;
+		}
+		file << "{\n";
+		file << "  \"renderer\": \"" << escape(renderer) << "\",\n";
+		if (!pose.empty())
+			file << "  \"pose\": \"" << escape(pose) << "\",\n";
+		file << "  \"frames\": " << samples.size() << ",\n";
+		file << "  \"mean_ms\": " << mean() << ",\n";
+		file << "  \"p50_ms\": " << percentile(50.0) << ",\n";
+		file << "  \"p95_ms\": " << percentile(95.0) << ",\n";
+		file << "  \"p99_ms\": " << percentile(99.0) << ",\n";
+		file << "  \"samples_ms\": [";
+		for (size_t i = 0; i < samples.size(); i++)
+			file << (i ? ", " : "") << samples[i];
+		file << "]\n}\n";
+		return true;
+	}
+
+private:
+	static std::string escape(const std::string &s)
+	{
+		std::string out;
+		for (char c : s)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			out += c;
+		}
+		return out;
+	}
+};
+#endif
@@ -0,0 +1,207 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Keys processInput reacts to, packed into a bitmask so a frame's keyboard state can be recorded
+enum InputKey {
+	INPUT_KEY_W = 1 << 0,
+	INPUT_KEY_S = 1 << 1,
+	INPUT_KEY_A = 1 << 2,
+	INPUT_KEY_D = 1 << 3,
+	INPUT_KEY_SPACE = 1 << 4,
+	INPUT_KEY_ESCAPE = 1 << 5,
+	INPUT_KEY_M = 1 << 6 // print the memory report
+};
+
+// Records camera state and input events to a compact binary file and plays them back.
+//
+// File layout (little endian):
+//   header: char magic[4] = "CPTH", uint32 version, uint32 frameCount, float fixedDeltaTime
+//   per frame: float time, float deltaTime, float position[3], float yaw, float pitch, float zoom,
+//              uint16 keys, uint16 eventCount, eventCount * { uint32 type, float x, float y }
+// Playback restores the recorded camera state of every frame and drives time from a fixed clock
+// (frame * fixedDeltaTime) instead of glfwGetTime, so two replays render identical frames.
+class CameraPath
+{
+public:
+	enum EventType {
+		EVENT_MOUSE_MOVE = 1, // x, y: offsets passed to Camera::ProcessMouseMovement
+		EVENT_SCROLL = 2      // y: offset passed to Camera::ProcessMouseScroll
+	};
+
+	struct Event {
+		uint32_t type;
+		float x, y;
+	};
+
+	struct Frame {
+		float time;
+		float deltaTime;
+		glm::vec3 position;
+		float yaw, pitch, zoom;
+		uint16_t keys;
+		std::vector<Event> events;
+	};
+
+	static const uint32_t VERSION = 1;
+
+	std::vector<Frame> frames;
+	float fixedDeltaTime;
+
+	CameraPath() : fixedDeltaTime(1.0f / 60.0f), recording(false), frameCount(0)
+	{
+	}
+
+	~CameraPath()
+	{
+		stopRecording();
+	}
+
+	// ------------------------------------------------------------------------
+	// recording
+	bool startRecording(const std::string &path)
+	{
+		file.open(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::CAMERA_PATH::CANNOT_WRITE " << path << std::endl;
+			return false;
+		}
+		recording = true;
+		frameCount = 0;
+		file.write("CPTH", 4);
+		write((uint32_t)VERSION);
+		write(frameCount);
+		write(fixedDeltaTime);
+		return true;
+	}
+
+	bool isRecording() const
+	{
+		return recording;
+	}
+
+	// queues an input event; it is stored with the next recorded frame
+	void addEvent(EventType type, float x, float y)
+	{
+		if (!recording)
+			return;
+		Event event = { (uint32_t)type, x, y };
+		pendingEvents.push_back(event);
+	}
+
+	// appends the state the frame is rendered with
+	void recordFrame(float time, float deltaTime, const Camera &camera, uint16_t keys)
+	{
+		if (!recording)
+			return;
+		write(time);
+		write(deltaTime);
+		write(camera.Position.x);
+		write(camera.Position.y);
+		write(camera.Position.z);
+		write(camera.Yaw);
+		write(camera.Pitch);
+		write(camera.Zoom);
+		write(keys);
+		write((uint16_t)pendingEvents.size());
+		for (size_t i = 0; i < pendingEvents.size(); i++)
+		{
+			write(pendingEvents[i].type);
+			write(pendingEvents[i].x);
+			write(pendingEvents[i].y);
+		}
+		pendingEvents.clear();
+		frameCount++;
+	}
+
+	// patches the frame count into the header and closes the file
+	void stopRecording()
+	{
+		if (!recording)
+			return;
+		recording = false;
+		file.seekp(8);
+		write(frameCount);
+		file.close();
+		std::cout << "Camera path: recorded " << frameCount << " frames" << std::endl;
+	}
+
+	// ------------------------------------------------------------------------
+	// playback
+	bool load(const std::string &path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		char magic[4];
+		uint32_t version = 0, count = 0;
+		if (!in.read(magic, 4) || std::memcmp(magic, "CPTH", 4) != 0 || !read(in, version) || version != VERSION || !read(in, count) || !read(in, fixedDeltaTime))
+		{
+			std::cout << "ERROR::CAMERA_PATH::INVALID_FILE " << path << std::endl;
+			return false;
+		}
+		frames.clear();
+		frames.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Frame frame;
+			uint16_t eventCount = 0;
+			if (!read(in, frame.time) || !read(in, frame.deltaTime) || !read(in, frame.position.x) || !read(in, frame.position.y) || !read(in, frame.position.z)
+				|| !read(in, frame.yaw) || !read(in, frame.pitch) || !read(in, frame.zoom) || !read(in, frame.keys) || !read(in, eventCount))
+				break;
+			frame.events.resize(eventCount);
+			bool complete = true;
+			for (uint16_t e = 0; e < eventCount && complete; e++)
+				complete = read(in, frame.events[e].type) && read(in, frame.events[e].x) && read(in, frame.events[e].y);
+			if (!complete)
+				break; // a frame with missing events is dropped along with the rest of the file
+			frames.push_back(frame);
+		}
+		if (frames.size() != count)
+			std::cout << "WARNING::CAMERA_PATH::TRUNCATED " << path << ": " << frames.size() << " of " << count << " frames" << std::endl;
+		std::cout << "Camera path: loaded " << frames.size() << " frames from " << path << std::endl;
+		return !frames.empty();
+	}
+
+	// time of a replayed frame on the fixed simulated clock
+	float sceneTime(int frame) const
+	{
+		return frame * fixedDeltaTime;
+	}
+
+	// puts the camera into the state it had when the frame was recorded
+	void apply(int frame, Camera &camera) const
+	{
+		const Frame &f = frames[frame];
+		camera.SetPose(f.position, f.yaw, f.pitch);
+		camera.Zoom = f.zoom;
+	}
+
+private:
+	std::ofstream file;
+	bool recording;
+	uint32_t frameCount;
+	std::vector<Event> pendingEvents;
+
+	template <typename T>
+	void write(const T &value)
+	{
+		file.write((const char*)&value, sizeof(T));
+	}
+
+	template <typename T>
+	static bool read(std::istream &in, T &value)
+	{
+		return (bool)in.read((char*)&value, sizeof(T));
+	}
+};
+#endif
@@ -0,0 +1,159 @@
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Scoped CPU profiling zones with nanosecond timestamps.
+// Each thread records into its own buffer (no locking on the hot path); the buffers are merged
+// when the trace is written as chrome://tracing / Perfetto JSON.
+// Define CPU_PROFILER_DISABLED to compile every zone out.
+class CpuProfiler
+{
+public:
+	struct Zone {
+		const char *name; // must be a string literal or otherwise outlive the profiler
+		uint64_t start;
+		uint64_t end;
+		uint32_t depth;
+	};
+
+	struct ThreadBuffer {
+		uint32_t threadId;
+		uint32_t depth = 0;
+		std::vector<Zone> zones;
+	};
+
+	static bool &enabled()
+	{
+		static bool value = false;
+		return value;
+	}
+
+	// nanoseconds since the first call
+	static uint64_t now()
+	{
+		static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	static ThreadBuffer &threadBuffer()
+	{
+		thread_local ThreadBuffer *buffer = registerThread();
+		return *buffer;
+	}
+
+	// writes all recorded zones of all threads as a Chrome trace event file
+	static bool writeChromeTrace(const std::string &path)
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			std::cout << "ERROR::CPU_PROFILER::CANNOT_WRITE " << path << std::endl;
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(registryMutex());
+		file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+		bool first = true;
+		size_t count = 0;
+		for (const std::unique_ptr<ThreadBuffer> &buffer : registry())
+		{
+			for (const Zone &zone : buffer->zones)
+			{
+				// trace event timestamps are in microseconds; keep the nanoseconds as fractions
+				file << (first ? "" : ",\n") << "{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+					<< ",\"ts\":" << zone.start / 1000 << "." << pad3(zone.start % 1000)
+					<< ",\"dur\":" << (zone.end - zone.start) / 1000 << "." << pad3((zone.end - zone.start) % 1000)
+					<< ",\"args\":{\"depth\":" << zone.depth << "}}";
+				first = false;
+				count++;
+			}
+		}
+		file << "\n]}\n";
+		std::cout << "CPU trace: " << count << " zones written to " << path << std::endl;
+		return true;
+	}
+
+	static void clear()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex());
+		for (const std::unique_ptr<ThreadBuffer> &buffer : registry())
+			buffer->zones.clear();
+	}
+
+private:
+	static std::vector<std::unique_ptr<ThreadBuffer> > &registry()
+	{
+		static std::vector<std::unique_ptr<ThreadBuffer> > buffers;
+		return buffers;
+	}
+
+	static std::mutex &registryMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static ThreadBuffer *registerThread()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex());
+		std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+		buffer->threadId = (uint32_t)registry().size() + 1;
+		buffer->zones.reserve(4096);
+		registry().push_back(std::move(buffer));
+		return registry().back().get();
+	}
+
+	static std::string pad3(uint64_t value)
+	{
+		std::string s = std::to_string(value);
+		return std::string(3 - s.size(), '0') + s;
+	}
+};
+
+// RAII zone; records nothing while the profiler is disabled
+class CpuZone
+{
+public:
+	explicit CpuZone(const char *name)
+	{
+		if (!CpuProfiler::enabled())
+		{
+			buffer = nullptr;
+			return;
+		}
+		buffer = &CpuProfiler::threadBuffer();
+		index = buffer->zones.size();
+		CpuProfiler::Zone zone = { name, CpuProfiler::now(), 0, buffer->depth++ };
+		buffer->zones.push_back(zone);
+	}
+	~CpuZone()
+	{
+		if (!buffer)
+			return;
+		buffer->zones[index].end = CpuProfiler::now();
+		buffer->depth--;
+	}
+private:
+	CpuProfiler::ThreadBuffer *buffer;
+	size_t index;
+};
+
+#define CPU_PROFILER_CONCAT_IMPL(a, b) a##b
+#define CPU_PROFILER_CONCAT(a, b) CPU_PROFILER_CONCAT_IMPL(a, b)
+#ifndef CPU_PROFILER_DISABLED
+#define PROFILE_ZONE(name) CpuZone CPU_PROFILER_CONCAT(cpuZone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#endif
+#endif
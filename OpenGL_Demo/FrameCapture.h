@@ -0,0 +1,281 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/glad.h>
+
+#include "CpuProfiler.h"
+#include "MemoryRegistry.h"
+#include "stb_image_write.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Records the default framebuffer of every frame without stalling the render loop.
+// glReadPixels writes into a ring of pixel pack buffers, so the call returns immediately; a buffer
+// is mapped RING_SIZE - 1 frames later, when its fence has normally signaled, copied into a pooled
+// CPU buffer and handed to a worker thread that encodes it:
+//   PNG  <directory>/frame_000000.png, one file per frame
+//   Y4M  <directory>/capture.y4m, 4:4:4 BT.601 video any player or ffmpeg reads directly
+//   RAW  <directory>/capture.rgba, top row first RGBA8 frames back to back
+// If the worker falls more than MAX_QUEUED frames behind, frames are dropped and counted rather
+// than blocking the render thread.
+class FrameCapture
+{
+public:
+	enum Format {
+		FORMAT_PNG,
+		FORMAT_Y4M,
+		FORMAT_RAW
+	};
+
+	static const int RING_SIZE = 3;
+	static const size_t MAX_QUEUED = 16;
+
+	FrameCapture(const std::string &directory, Format format, int width, int height, int fps = 60)
+		: directory(directory), format(format), width(width), height(height), fps(fps), frame(0), dropped(0), written(0), stopping(false)
+	{
+		makeDirectory(directory);
+		// GL rows start at the bottom; set once here, before the worker exists, so no thread races on the flag
+		stbi_flip_vertically_on_write(1);
+		if (format != FORMAT_PNG)
+		{
+			std::string path = directory + (format == FORMAT_Y4M ? "/capture.y4m" : "/capture.rgba");
+			stream.open(path, std::ios::binary | std::ios::trunc);
+			if (!stream)
+				std::cout << "ERROR::FRAME_CAPTURE::CANNOT_WRITE " << path << std::endl;
+			else if (format == FORMAT_Y4M)
+				stream << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C444\n";
+		}
+		glGenBuffers(RING_SIZE, pbos);
+		for (int i = 0; i < RING_SIZE; i++)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes(), NULL, GL_STREAM_READ);
+			MemoryRegistry::instance().addBuffer(pbos[i], "frame_capture", MemoryRegistry::READBACK_BUFFER, frameBytes());
+			fences[i] = 0;
+			frames[i] = -1;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		worker = std::thread(&FrameCapture::encodeLoop, this);
+	}
+
+	~FrameCapture()
+	{
+		finish();
+		for (int i = 0; i < RING_SIZE; i++)
+			MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_BUFFER, pbos[i]);
+		glDeleteBuffers(RING_SIZE, pbos);
+	}
+
+	// queues a readback of the bound read framebuffer (call after the last draw, before swapping)
+	void capture()
+	{
+		PROFILE_ZONE("FrameCapture::capture");
+		int slot = frame % RING_SIZE;
+		// map the readback issued RING_SIZE - 1 frames ago; the slot written now was collected last frame
+		collect((frame + 1) % RING_SIZE);
+		collect(slot);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		frames[slot] = frame;
+		frame++;
+	}
+
+	// collects the frames still in flight, waits for the worker to write everything and closes the output
+	void finish()
+	{
+		if (!worker.joinable())
+			return;
+		for (int i = 1; i <= RING_SIZE; i++)
+			collect((frame + i) % RING_SIZE);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		worker.join();
+		stream.close();
+		std::cout << "Frame capture: " << written << " of " << frame << " frames written to " << directory << ", " << dropped << " dropped" << std::endl;
+	}
+
+	static bool parseFormat(const std::string &name, Format &format)
+	{
+		if (name == "png")
+			format = FORMAT_PNG;
+		else if (name == "y4m")
+			format = FORMAT_Y4M;
+		else if (name == "raw")
+			format = FORMAT_RAW;
+		else
+			return false;
+		return true;
+	}
+
+private:
+	struct Job {
+		int frame;
+		std::vector<unsigned char> pixels;
+	};
+
+	std::string directory;
+	Format format;
+	int width, height, fps;
+	int frame;
+	GLuint pbos[RING_SIZE];
+	GLsync fences[RING_SIZE];
+	int frames[RING_SIZE];      // frame read into each slot, -1 if none is pending
+	unsigned int dropped;
+	unsigned int written;       // owned by the worker until it is joined
+	std::ofstream stream;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Job> queue;
+	std::vector<std::vector<unsigned char> > pool; // recycled pixel buffers
+	bool stopping;
+
+	size_t frameBytes() const
+	{
+		return (size_t)width * height * 4;
+	}
+
+	// maps a pending slot and passes its pixels to the worker
+	void collect(int slot)
+	{
+		if (frames[slot] < 0)
+			return;
+		// normally signaled already; waiting here only happens when the GPU is RING_SIZE frames behind
+		glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fences[slot]);
+		fences[slot] = 0;
+
+		Job job;
+		job.frame = frames[slot];
+		frames[slot] = -1;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (queue.size() >= MAX_QUEUED)
+			{
+				dropped++;
+				return;
+			}
+			if (!pool.empty())
+			{
+				job.pixels.swap(pool.back());
+				pool.pop_back();
+			}
+		}
+		job.pixels.resize(frameBytes());
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+		void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes(), GL_MAP_READ_BIT);
+		if (data)
+		{
+			std::memcpy(&job.pixels[0], data, frameBytes());
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		if (!data)
+		{
+			std::cout << "ERROR::FRAME_CAPTURE::MAP_FAILED frame " << job.frame << std::endl;
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(Job());
+			queue.back().frame = job.frame;
+			queue.back().pixels.swap(job.pixels);
+		}
+		wake.notify_one();
+	}
+
+	void encodeLoop()
+	{
+		std::vector<unsigned char> planes;
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this] { return stopping || !queue.empty(); });
+				if (queue.empty())
+					return;
+				job.frame = queue.front().frame;
+				job.pixels.swap(queue.front().pixels);
+				queue.pop_front();
+			}
+			PROFILE_ZONE("FrameCapture::encode");
+			if (format == FORMAT_PNG)
+			{
+				char name[32];
+				std::snprintf(name, sizeof(name), "/frame_%06d.png", job.frame);
+				if (stbi_write_png((directory + name).c_str(), width, height, 4, &job.pixels[0], width * 4))
+					written++;
+			}
+			else if (stream)
+			{
+				if (format == FORMAT_Y4M)
+				{
+					toYCbCr(job.pixels, planes);
+					stream << "FRAME\n";
+					stream.write((const char*)&planes[0], planes.size());
+				}
+				else
+				{
+					for (int y = height - 1; y >= 0; y--)
+						stream.write((const char*)&job.pixels[(size_t)y * width * 4], width * 4);
+				}
+				written++;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			pool.push_back(std::vector<unsigned char>());
+			pool.back().swap(job.pixels);
+		}
+	}
+
+	// bottom-up RGBA to top-down planar Y, Cb, Cr (BT.601, studio range)
+	void toYCbCr(const std::vector<unsigned char> &rgba, std::vector<unsigned char> &planes) const
+	{
+		size_t pixels = (size_t)width * height;
+		planes.resize(pixels * 3);
+		unsigned char *Y = &planes[0], *Cb = Y + pixels, *Cr = Cb + pixels;
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned char *row = &rgba[(size_t)(height - 1 - y) * width * 4];
+			for (int x = 0; x < width; x++)
+			{
+				int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+				size_t i = (size_t)y * width + x;
+				Y[i] = (unsigned char)((66 * r + 129 * g + 25 * b + 128) / 256 + 16);
+				Cb[i] = (unsigned char)((-38 * r - 74 * g + 112 * b + 128 + 128 * 256) / 256);
+				Cr[i] = (unsigned char)((112 * r - 94 * g - 18 * b + 128 + 128 * 256) / 256);
+			}
+		}
+	}
+
+	static void makeDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+};
+#endif
@@ -0,0 +1,112 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "MemoryRegistry.h"
+#include "Shader.h"
+
+#include <string>
+
+// CPU mirrors of the std140 uniform blocks declared by the shaders. std140 aligns every vec3 to
+// 16 bytes; a float declared right after a vec3 fills the remaining 4, otherwise explicit padding does.
+struct CameraBlock {
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec3 cameraPosition;
+	float pad0;
+};
+
+struct DirLightStd140 {
+	glm::vec3 direction;
+	float pad0;
+	glm::vec3 ambient;
+	float pad1;
+	glm::vec3 diffuse;
+	float pad2;
+	glm::vec3 specular;
+	float pad3;
+};
+
+struct PointLightStd140 {
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	float pad0;
+	glm::vec3 color; // radiance for the PBR shader
+	float pad1;
+};
+
+const int NR_POINT_LIGHTS = 2;
+
+struct LightsBlock {
+	DirLightStd140 dirLight;
+	PointLightStd140 pointLights[NR_POINT_LIGHTS];
+};
+
+// GLSL defines that size the shader side of the blocks (shaders/include/lights.glsl) to match
+inline std::string frameUniformDefines()
+{
+	return "#define NR_POINT_LIGHTS " + std::to_string(NR_POINT_LIGHTS) + "\n";
+}
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock must match the std140 layout of the Camera block");
+static_assert(sizeof(DirLightStd140) == 64 && sizeof(PointLightStd140) == 80, "light structs must match their std140 layout");
+
+// Owns the per-frame uniform buffers. Fill `camera` and `lights`, then upload() once per frame: each
+// block goes up in a single glBufferData call and stays bound to its binding point for every program.
+class FrameUniforms
+{
+public:
+	CameraBlock camera;
+	LightsBlock lights;
+
+	FrameUniforms() : camera(), lights()
+	{
+		glGenBuffers(1, &cameraUBO);
+		glGenBuffers(1, &lightsUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, lightsUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(LightsBlock), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, cameraUBO);
+		glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BLOCK_BINDING, lightsUBO);
+		MemoryRegistry::instance().addBuffer(cameraUBO, "camera_block", MemoryRegistry::UNIFORM_BUFFER, sizeof(CameraBlock));
+		MemoryRegistry::instance().addBuffer(lightsUBO, "lights_block", MemoryRegistry::UNIFORM_BUFFER, sizeof(LightsBlock));
+	}
+
+	~FrameUniforms()
+	{
+		MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_BUFFER, cameraUBO);
+		MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_BUFFER, lightsUBO);
+		glDeleteBuffers(1, &cameraUBO);
+		glDeleteBuffers(1, &lightsUBO);
+	}
+
+	void setCamera(const glm::mat4 &projection, const glm::mat4 &view, const glm::vec3 &position)
+	{
+		camera.projection = projection;
+		camera.view = view;
+		camera.cameraPosition = position;
+	}
+
+	// replaces the contents of both buffers (glBufferData with data orphans the storage in flight)
+	void upload()
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), &camera, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, lightsUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(LightsBlock), &lights, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+private:
+	unsigned int cameraUBO, lightsUBO;
+};
+#endif
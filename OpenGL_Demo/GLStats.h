@@ -0,0 +1,361 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// GL call interception layer.
+// install() swaps glad's function pointers for counting trampolines (the same pre-call hook glad's
+// debug generator would emit) so every GL call made by the renderer is counted per frame by entry
+// point. A shadow of the binding state flags redundant binds, and draws/uploads are summarized as
+// draw calls, triangles and bytes. Nothing is hooked until install() runs, so a normal run pays nothing.
+class GLStats
+{
+public:
+	struct FrameCounters {
+		unsigned long long calls = 0;
+		unsigned long long drawCalls = 0;
+		unsigned long long triangles = 0;
+		unsigned long long bytesUploaded = 0;
+		unsigned long long redundantPrograms = 0;
+		unsigned long long redundantVertexArrays = 0;
+		unsigned long long redundantTextures = 0;
+		unsigned long long redundantActiveTexture = 0;
+		unsigned long long redundantBuffers = 0;
+		unsigned long long redundantState = 0;
+		// glGetUniformLocation issued between beginFrame and endFrame
+		unsigned long long uniformLookups = 0;
+		std::vector<unsigned long long> perEntryPoint;
+	};
+
+	// print a summary every logInterval frames (0 disables logging)
+	unsigned int logInterval = 120;
+
+	static GLStats &instance()
+	{
+		static GLStats stats;
+		return stats;
+	}
+
+	// hooks the entry points; call once, right after gladLoadGLLoader
+	void install();
+
+	bool isInstalled() const
+	{
+		return installed;
+	}
+
+	void beginFrame()
+	{
+		current = FrameCounters();
+		current.perEntryPoint.assign(names.size(), 0);
+		inFrame = true;
+	}
+
+	void endFrame()
+	{
+		inFrame = false;
+		last = current;
+		frame++;
+		if (logInterval > 0 && frame % logInterval == 0)
+			log(std::cout);
+	}
+
+	// counters of the most recently finished frame
+	const FrameCounters &getLastFrame() const
+	{
+		return last;
+	}
+
+	const std::string &getEntryPointName(size_t slot) const
+	{
+		return names[slot];
+	}
+
+	void log(std::ostream &out, size_t topEntryPoints = 8) const
+	{
+		if (!installed)
+			return;
+		out << "GL: " << last.calls << " calls | " << last.drawCalls << " draws | " << last.triangles << " triangles | "
+			<< last.bytesUploaded << " bytes uploaded | " << last.uniformLookups << " glGetUniformLocation" << std::endl;
+		out << "GL redundant: program " << last.redundantPrograms << " | vao " << last.redundantVertexArrays
+			<< " | texture " << last.redundantTextures << " | active texture " << last.redundantActiveTexture
+			<< " | buffer " << last.redundantBuffers << " | state " << last.redundantState << std::endl;
+		std::vector<std::pair<unsigned long long, size_t> > sorted;
+		for (size_t i = 0; i < last.perEntryPoint.size(); i++)
+			if (last.perEntryPoint[i] > 0)
+				sorted.push_back(std::make_pair(last.perEntryPoint[i], i));
+		std::sort(sorted.rbegin(), sorted.rend());
+		out << "GL top calls:";
+		for (size_t i = 0; i < sorted.size() && i < topEntryPoints; i++)
+			out << " " << names[sorted[i].second] << " " << sorted[i].first;
+		out << std::endl;
+	}
+
+	// ------------------------------------------------------------------------
+	// used by the trampolines
+	void count(unsigned int slot)
+	{
+		current.calls++;
+		if (slot < current.perEntryPoint.size())
+			current.perEntryPoint[slot]++;
+	}
+
+	unsigned int addEntryPoint(const char *name)
+	{
+		names.push_back(name);
+		current.perEntryPoint.resize(names.size(), 0);
+		return (unsigned int)names.size() - 1;
+	}
+
+	void addDraw(GLenum mode, GLsizei count, GLsizei instances = 1)
+	{
+		current.drawCalls++;
+		unsigned long long primitives = 0;
+		if (mode == GL_TRIANGLES)
+			primitives = count / 3;
+		else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count >= 3)
+			primitives = count - 2;
+		current.triangles += primitives * instances;
+	}
+
+	void addUpload(unsigned long long bytes)
+	{
+		current.bytesUploaded += bytes;
+	}
+
+	static unsigned long long textureBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+	{
+		unsigned long long components = 4;
+		if (format == GL_RED || format == GL_DEPTH_COMPONENT)
+			components = 1;
+		else if (format == GL_RG)
+			components = 2;
+		else if (format == GL_RGB || format == GL_BGR)
+			components = 3;
+		unsigned long long size = 1;
+		if (type == GL_FLOAT || type == GL_INT || type == GL_UNSIGNED_INT)
+			size = 4;
+		else if (type == GL_HALF_FLOAT || type == GL_SHORT || type == GL_UNSIGNED_SHORT)
+			size = 2;
+		return (unsigned long long)width * height * components * size;
+	}
+
+	// shadowed binding state, used to detect redundant binds
+	GLuint program = 0;
+	GLuint vertexArray = 0;
+	GLenum activeTexture = GL_TEXTURE0;
+	std::map<std::pair<GLenum, GLenum>, GLuint> textures;
+	std::map<GLenum, GLuint> buffers;
+	GLenum depthFunc = GL_LESS;
+	GLboolean depthMask = GL_TRUE;
+	GLenum blendSrc = GL_ONE;
+	GLenum blendDst = GL_ZERO;
+	FrameCounters current;
+	bool inFrame = false;
+
+private:
+	bool installed = false;
+	unsigned int frame = 0;
+	std::vector<std::string> names;
+	FrameCounters last;
+
+	GLStats()
+	{
+	}
+
+	template <int Id, typename Fn>
+	void hook(Fn &pointer, const char *name);
+};
+
+// per entry point observers: the generic one only counts, specializations inspect the arguments
+// ------------------------------------------------------------------------
+template <int Id>
+struct GLObserver
+{
+	template <typename... Args>
+	static void observe(GLStats &, Args...)
+	{
+	}
+};
+
+// one id per hooked entry point, e.g. GLSTATS_glUseProgram
+enum GLStatsHook {
+#define GL_STATS_ENTRY_POINT(fn) GLSTATS_##fn,
+#include "GLStatsEntryPoints.h"
+#undef GL_STATS_ENTRY_POINT
+};
+
+template <> struct GLObserver<GLSTATS_glUseProgram> {
+	static void observe(GLStats &s, GLuint program)
+	{
+		if (program == s.program)
+			s.current.redundantPrograms++;
+		s.program = program;
+	}
+};
+template <> struct GLObserver<GLSTATS_glBindVertexArray> {
+	static void observe(GLStats &s, GLuint array)
+	{
+		if (array == s.vertexArray)
+			s.current.redundantVertexArrays++;
+		s.vertexArray = array;
+	}
+};
+template <> struct GLObserver<GLSTATS_glActiveTexture> {
+	static void observe(GLStats &s, GLenum unit)
+	{
+		if (unit == s.activeTexture)
+			s.current.redundantActiveTexture++;
+		s.activeTexture = unit;
+	}
+};
+template <> struct GLObserver<GLSTATS_glBindTexture> {
+	static void observe(GLStats &s, GLenum target, GLuint texture)
+	{
+		std::map<std::pair<GLenum, GLenum>, GLuint>::iterator it = s.textures.find(std::make_pair(s.activeTexture, target));
+		if (it != s.textures.end() && it->second == texture)
+			s.current.redundantTextures++;
+		s.textures[std::make_pair(s.activeTexture, target)] = texture;
+	}
+};
+template <> struct GLObserver<GLSTATS_glBindBuffer> {
+	static void observe(GLStats &s, GLenum target, GLuint buffer)
+	{
+		// the element array binding belongs to the VAO, so only array/pixel buffers are shadowed
+		if (target == GL_ELEMENT_ARRAY_BUFFER)
+			return;
+		std::map<GLenum, GLuint>::iterator it = s.buffers.find(target);
+		if (it != s.buffers.end() && it->second == buffer)
+			s.current.redundantBuffers++;
+		s.buffers[target] = buffer;
+	}
+};
+template <> struct GLObserver<GLSTATS_glDepthFunc> {
+	static void observe(GLStats &s, GLenum func)
+	{
+		if (func == s.depthFunc)
+			s.current.redundantState++;
+		s.depthFunc = func;
+	}
+};
+template <> struct GLObserver<GLSTATS_glDepthMask> {
+	static void observe(GLStats &s, GLboolean flag)
+	{
+		if (flag == s.depthMask)
+			s.current.redundantState++;
+		s.depthMask = flag;
+	}
+};
+template <> struct GLObserver<GLSTATS_glBlendFunc> {
+	static void observe(GLStats &s, GLenum sfactor, GLenum dfactor)
+	{
+		if (sfactor == s.blendSrc && dfactor == s.blendDst)
+			s.current.redundantState++;
+		s.blendSrc = sfactor;
+		s.blendDst = dfactor;
+	}
+};
+template <> struct GLObserver<GLSTATS_glGetUniformLocation> {
+	static void observe(GLStats &s, GLuint, const GLchar *)
+	{
+		if (s.inFrame)
+			s.current.uniformLookups++;
+	}
+};
+template <> struct GLObserver<GLSTATS_glDrawArrays> {
+	static void observe(GLStats &s, GLenum mode, GLint, GLsizei count)
+	{
+		s.addDraw(mode, count);
+	}
+};
+template <> struct GLObserver<GLSTATS_glDrawElements> {
+	static void observe(GLStats &s, GLenum mode, GLsizei count, GLenum, const void *)
+	{
+		s.addDraw(mode, count);
+	}
+};
+template <> struct GLObserver<GLSTATS_glDrawElementsBaseVertex> {
+	static void observe(GLStats &s, GLenum mode, GLsizei count, GLenum, const void *, GLint)
+	{
+		s.addDraw(mode, count);
+	}
+};
+template <> struct GLObserver<GLSTATS_glBufferData> {
+	static void observe(GLStats &s, GLenum, GLsizeiptr size, const void *data, GLenum)
+	{
+		if (data)
+			s.addUpload(size);
+	}
+};
+template <> struct GLObserver<GLSTATS_glBufferSubData> {
+	static void observe(GLStats &s, GLenum, GLintptr, GLsizeiptr size, const void *)
+	{
+		s.addUpload(size);
+	}
+};
+template <> struct GLObserver<GLSTATS_glTexImage2D> {
+	static void observe(GLStats &s, GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void *pixels)
+	{
+		if (pixels)
+			s.addUpload(GLStats::textureBytes(width, height, format, type));
+	}
+};
+template <> struct GLObserver<GLSTATS_glTexSubImage2D> {
+	static void observe(GLStats &s, GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *)
+	{
+		s.addUpload(GLStats::textureBytes(width, height, format, type));
+	}
+};
+
+// trampoline replacing one glad function pointer
+// ------------------------------------------------------------------------
+template <int Id, typename Fn>
+struct GLHook;
+
+template <int Id, typename R, typename... Args>
+struct GLHook<Id, R (APIENTRYP)(Args...)>
+{
+	static R (APIENTRYP original)(Args...);
+	static unsigned int slot;
+
+	static R APIENTRY call(Args... args)
+	{
+		GLStats &stats = GLStats::instance();
+		stats.count(slot);
+		GLObserver<Id>::observe(stats, args...);
+		return original(args...);
+	}
+};
+template <int Id, typename R, typename... Args>
+R (APIENTRYP GLHook<Id, R (APIENTRYP)(Args...)>::original)(Args...) = nullptr;
+template <int Id, typename R, typename... Args>
+unsigned int GLHook<Id, R (APIENTRYP)(Args...)>::slot = 0;
+
+template <int Id, typename Fn>
+void GLStats::hook(Fn &pointer, const char *name)
+{
+	if (!pointer)
+		return;
+	GLHook<Id, Fn>::original = pointer;
+	GLHook<Id, Fn>::slot = addEntryPoint(name);
+	pointer = &GLHook<Id, Fn>::call;
+}
+
+inline void GLStats::install()
+{
+	if (installed)
+		return;
+	installed = true;
+#define GL_STATS_ENTRY_POINT(fn) hook<GLSTATS_##fn>(glad_##fn, #fn);
+#include "GLStatsEntryPoints.h"
+#undef GL_STATS_ENTRY_POINT
+	current.perEntryPoint.assign(names.size(), 0);
+}
+#endif
@@ -0,0 +1,92 @@
+// Every glad entry point GLStats::install() hooks, one per line, expanded through GL_STATS_ENTRY_POINT
+// (no include guard on purpose). Generated from the GL calls in the sources:
+//   grep -ohE '\bgl[A-Z][A-Za-z0-9]*\s*\(' $(ls *.h *.cpp | grep -v '^stb_') | sed 's/\s*($//' | sort -u
+// filtered to the names glad.h declares. Add new calls here, or they go uncounted. Entries nothing
+// calls yet cost nothing. ProgramCache loads its program binary entry points itself, outside glad.
+GL_STATS_ENTRY_POINT(glActiveTexture)
+GL_STATS_ENTRY_POINT(glAttachShader)
+GL_STATS_ENTRY_POINT(glBindBuffer)
+GL_STATS_ENTRY_POINT(glBindBufferBase)
+GL_STATS_ENTRY_POINT(glBindFramebuffer)
+GL_STATS_ENTRY_POINT(glBindRenderbuffer)
+GL_STATS_ENTRY_POINT(glBindTexture)
+GL_STATS_ENTRY_POINT(glBindVertexArray)
+GL_STATS_ENTRY_POINT(glBlendFunc)
+GL_STATS_ENTRY_POINT(glBufferData)
+GL_STATS_ENTRY_POINT(glBufferSubData)
+GL_STATS_ENTRY_POINT(glCheckFramebufferStatus)
+GL_STATS_ENTRY_POINT(glClear)
+GL_STATS_ENTRY_POINT(glClearColor)
+GL_STATS_ENTRY_POINT(glClientWaitSync)
+GL_STATS_ENTRY_POINT(glCompileShader)
+GL_STATS_ENTRY_POINT(glCreateProgram)
+GL_STATS_ENTRY_POINT(glCreateShader)
+GL_STATS_ENTRY_POINT(glCullFace)
+GL_STATS_ENTRY_POINT(glDeleteBuffers)
+GL_STATS_ENTRY_POINT(glDeleteProgram)
+GL_STATS_ENTRY_POINT(glDeleteQueries)
+GL_STATS_ENTRY_POINT(glDeleteShader)
+GL_STATS_ENTRY_POINT(glDeleteSync)
+GL_STATS_ENTRY_POINT(glDeleteTextures)
+GL_STATS_ENTRY_POINT(glDeleteVertexArrays)
+GL_STATS_ENTRY_POINT(glDepthFunc)
+GL_STATS_ENTRY_POINT(glDepthMask)
+GL_STATS_ENTRY_POINT(glDisable)
+GL_STATS_ENTRY_POINT(glDrawArrays)
+GL_STATS_ENTRY_POINT(glDrawElements)
+GL_STATS_ENTRY_POINT(glDrawElementsBaseVertex)
+GL_STATS_ENTRY_POINT(glEnable)
+GL_STATS_ENTRY_POINT(glEnableVertexAttribArray)
+GL_STATS_ENTRY_POINT(glFenceSync)
+GL_STATS_ENTRY_POINT(glFinish)
+GL_STATS_ENTRY_POINT(glFlush)
+GL_STATS_ENTRY_POINT(glFramebufferRenderbuffer)
+GL_STATS_ENTRY_POINT(glFramebufferTexture2D)
+GL_STATS_ENTRY_POINT(glFrontFace)
+GL_STATS_ENTRY_POINT(glGenBuffers)
+GL_STATS_ENTRY_POINT(glGenFramebuffers)
+GL_STATS_ENTRY_POINT(glGenQueries)
+GL_STATS_ENTRY_POINT(glGenRenderbuffers)
+GL_STATS_ENTRY_POINT(glGenTextures)
+GL_STATS_ENTRY_POINT(glGenVertexArrays)
+GL_STATS_ENTRY_POINT(glGenerateMipmap)
+GL_STATS_ENTRY_POINT(glGetActiveUniform)
+GL_STATS_ENTRY_POINT(glGetIntegerv)
+GL_STATS_ENTRY_POINT(glGetProgramInfoLog)
+GL_STATS_ENTRY_POINT(glGetProgramiv)
+GL_STATS_ENTRY_POINT(glGetQueryObjectiv)
+GL_STATS_ENTRY_POINT(glGetQueryObjectui64v)
+GL_STATS_ENTRY_POINT(glGetShaderInfoLog)
+GL_STATS_ENTRY_POINT(glGetShaderiv)
+GL_STATS_ENTRY_POINT(glGetString)
+GL_STATS_ENTRY_POINT(glGetStringi)
+GL_STATS_ENTRY_POINT(glGetUniformBlockIndex)
+GL_STATS_ENTRY_POINT(glGetUniformLocation)
+GL_STATS_ENTRY_POINT(glLinkProgram)
+GL_STATS_ENTRY_POINT(glMapBufferRange)
+GL_STATS_ENTRY_POINT(glPixelStorei)
+GL_STATS_ENTRY_POINT(glPolygonMode)
+GL_STATS_ENTRY_POINT(glQueryCounter)
+GL_STATS_ENTRY_POINT(glReadPixels)
+GL_STATS_ENTRY_POINT(glRenderbufferStorage)
+GL_STATS_ENTRY_POINT(glShaderSource)
+GL_STATS_ENTRY_POINT(glTexImage2D)
+GL_STATS_ENTRY_POINT(glTexParameteri)
+GL_STATS_ENTRY_POINT(glTexSubImage2D)
+GL_STATS_ENTRY_POINT(glUniform1f)
+GL_STATS_ENTRY_POINT(glUniform1i)
+GL_STATS_ENTRY_POINT(glUniform2f)
+GL_STATS_ENTRY_POINT(glUniform2fv)
+GL_STATS_ENTRY_POINT(glUniform3f)
+GL_STATS_ENTRY_POINT(glUniform3fv)
+GL_STATS_ENTRY_POINT(glUniform4f)
+GL_STATS_ENTRY_POINT(glUniform4fv)
+GL_STATS_ENTRY_POINT(glUniformBlockBinding)
+GL_STATS_ENTRY_POINT(glUniformMatrix2fv)
+GL_STATS_ENTRY_POINT(glUniformMatrix3fv)
+GL_STATS_ENTRY_POINT(glUniformMatrix4fv)
+GL_STATS_ENTRY_POINT(glUnmapBuffer)
+GL_STATS_ENTRY_POINT(glUseProgram)
+GL_STATS_ENTRY_POINT(glVertexAttribDivisor)
+GL_STATS_ENTRY_POINT(glVertexAttribPointer)
+GL_STATS_ENTRY_POINT(glViewport)
@@ -0,0 +1,259 @@
+#ifndef GOLDEN_TEST_H
+#define GOLDEN_TEST_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Benchmark.h"
+#include "Camera.h"
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Golden-image regression harness.
+// Renders the scene from a fixed set of camera poses at a fixed scene time, reads back the HDR
+// color buffer and the tonemapped LDR framebuffer and compares them against stored goldens with a
+// perceptual (CIELAB delta E) tolerance. Frame timings of every pose are written next to its images.
+//
+// Layout of the golden directory:
+//   <pose>_ldr.png / <pose>_hdr.hdr                   stored goldens (written by --update-golden)
+//   <pose>_ldr_current.png / <pose>_hdr_current.hdr   images of the last run
+//   <pose>_ldr_diff.png                               delta E heat map, only for failed poses
+//   <pose>_timing.json                                frame times of the pose
+// Goldens are not committed: they depend on the driver, so each machine renders its own set at a
+// known-good commit with --update-golden (golden/README.md).
+class GoldenTest
+{
+public:
+	struct Pose {
+		std::string name;
+		glm::vec3 position;
+		float yaw;
+		float pitch;
+	};
+
+	struct Comparison {
+		double meanDeltaE;
+		double maxDeltaE;
+		double badFraction; // share of pixels above the per-pixel threshold
+	};
+
+	static const int WARMUP_FRAMES = 5;
+	static const int TIMED_FRAMES = 30;
+	// a pixel differs visibly above ~2.3 delta E (one just noticeable difference)
+	static constexpr double PIXEL_DELTA_E = 2.3;
+
+	std::vector<Pose> poses;
+	// animation time every pose is rendered at, so light positions and colors are deterministic
+	float sceneTime;
+	std::string directory;
+	bool update;
+	// a pose fails when more than this share of its pixels differ visibly
+	double tolerance;
+	int failures;
+
+	GoldenTest(const std::string &directory, bool update, double tolerance) : sceneTime(1.0f), directory(directory), update(update), tolerance(tolerance), failures(0)
+	{
+		poses.push_back(Pose{ "front", glm::vec3(0.0f, 0.5f, 5.0f), -90.0f, -5.0f });
+		poses.push_back(Pose{ "back", glm::vec3(0.0f, 0.5f, -5.0f), 90.0f, -5.0f });
+		poses.push_back(Pose{ "left", glm::vec3(-5.0f, 1.0f, 0.0f), 0.0f, -10.0f });
+		poses.push_back(Pose{ "right", glm::vec3(5.0f, 1.0f, 0.0f), 180.0f, -10.0f });
+		poses.push_back(Pose{ "top", glm::vec3(0.0f, 6.0f, 0.0f), -90.0f, -89.0f });
+	}
+
+	int framesPerPose() const
+	{
+		return WARMUP_FRAMES + TIMED_FRAMES + 1;
+	}
+
+	int totalFrames() const
+	{
+		return (int)poses.size() * framesPerPose();
+	}
+
+	// moves the camera to the pose the given frame belongs to
+	void beginFrame(int frame, Camera &camera)
+	{
+		const Pose &pose = poses[frame / framesPerPose()];
+		camera.SetPose(pose.position, pose.yaw, pose.pitch);
+		camera.Zoom = ZOOM;
+	}
+
+	bool isTimedFrame(int frame) const
+	{
+		int local = frame % framesPerPose();
+		return local >= WARMUP_FRAMES && local < WARMUP_FRAMES + TIMED_FRAMES;
+	}
+
+	// the last frame of a pose is read back instead of timed, so readback cost stays out of the timings
+	bool isCaptureFrame(int frame) const
+	{
+		return frame % framesPerPose() == framesPerPose() - 1;
+	}
+
+	void addTiming(double ms)
+	{
+		timings.addSample(ms);
+	}
+
+	// reads back the HDR buffer and the default framebuffer and compares or stores them.
+	// Must run before the buffers are swapped.
+	void capture(int frame, unsigned int hdrFBO, int width, int height)
+	{
+		const Pose &pose = poses[frame / framesPerPose()];
+		std::string base = directory + "/" + pose.name;
+		makeDirectory(directory);
+
+		std::vector<float> hdrPixels(width * height * 3);
+		std::vector<unsigned char> ldrPixels(width * height * 3);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, hdrFBO);
+		glReadPixels(0, 0, width, height, GL_RGB, GL_FLOAT, &hdrPixels[0]);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &ldrPixels[0]);
+
+		// GL rows start at the bottom, image files at the top
+		stbi_flip_vertically_on_write(1);
+		const char *renderer = (const char*)glGetString(GL_RENDERER);
+		timings.writeJson(base + "_timing.json", renderer ? renderer : "unknown", pose.name);
+		timings.print(std::cout, "Golden " + pose.name + " frame time");
+		timings.samples.clear();
+
+		if (update)
+		{
+			stbi_write_png((base + "_ldr.png").c_str(), width, height, 3, &ldrPixels[0], width * 3);
+			stbi_write_hdr((base + "_hdr.hdr").c_str(), width, height, 3, &hdrPixels[0]);
+			std::cout << "Golden " << pose.name << ": updated" << std::endl;
+			return;
+		}
+		stbi_write_png((base + "_ldr_current.png").c_str(), width, height, 3, &ldrPixels[0], width * 3);
+		stbi_write_hdr((base + "_hdr_current.hdr").c_str(), width, height, 3, &hdrPixels[0]);
+
+		// goldens are stored top row first; flip them back to GL order for comparison
+		stbi_set_flip_vertically_on_load(1);
+		int w, h, n;
+		unsigned char *goldenLdr = stbi_load((base + "_ldr.png").c_str(), &w, &h, &n, 3);
+		float *goldenHdr = stbi_loadf((base + "_hdr.hdr").c_str(), &w, &h, &n, 3);
+		stbi_set_flip_vertically_on_load(0);
+		if (!goldenLdr || !goldenHdr)
+			std::cout << "Golden " << pose.name << ": FAILED, no golden in " << directory << " (generate them at a known-good commit with --update-golden, see golden/README.md)" << std::endl;
+		else if (w != width || h != height)
+			std::cout << "Golden " << pose.name << ": FAILED, golden is " << w << "x" << h << ", rendered " << width << "x" << height << " (regenerate with --update-golden)" << std::endl;
+		if (!goldenLdr || !goldenHdr || w != width || h != height)
+		{
+			failures++;
+			stbi_image_free(goldenLdr);
+			stbi_image_free(goldenHdr);
+			return;
+		}
+
+		std::vector<unsigned char> heatMap(width * height * 3);
+		Comparison ldr = compareLdr(&ldrPixels[0], goldenLdr, width * height, &heatMap[0]);
+		Comparison hdr = compareHdr(&hdrPixels[0], goldenHdr, width * height);
+		stbi_image_free(goldenLdr);
+		stbi_image_free(goldenHdr);
+
+		bool passed = ldr.badFraction <= tolerance && hdr.badFraction <= tolerance;
+		std::cout << "Golden " << pose.name << ": " << (passed ? "passed" : "FAILED")
+			<< " | ldr mean dE " << ldr.meanDeltaE << " max " << ldr.maxDeltaE << " bad " << ldr.badFraction * 100.0 << "%"
+			<< " | hdr mean dE " << hdr.meanDeltaE << " max " << hdr.maxDeltaE << " bad " << hdr.badFraction * 100.0 << "%" << std::endl;
+		if (!passed)
+		{
+			stbi_write_png((base + "_ldr_diff.png").c_str(), width, height, 3, &heatMap[0], width * 3);
+			failures++;
+		}
+	}
+
+	void report() const
+	{
+		std::cout << "Golden images: " << (poses.size() - failures) << "/" << poses.size() << " poses passed" << std::endl;
+	}
+
+private:
+	FrameStats timings;
+
+	static void makeDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+	// sRGB encoded [0,1] color to CIELAB (D65)
+	static glm::vec3 toLab(glm::vec3 srgb)
+	{
+		glm::vec3 c;
+		for (int i = 0; i < 3; i++)
+			c[i] = srgb[i] <= 0.04045f ? srgb[i] / 12.92f : std::pow((srgb[i] + 0.055f) / 1.055f, 2.4f);
+		glm::vec3 xyz(0.4124f * c.r + 0.3576f * c.g + 0.1805f * c.b,
+			0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b,
+			0.0193f * c.r + 0.1192f * c.g + 0.9505f * c.b);
+		xyz /= glm::vec3(0.95047f, 1.0f, 1.08883f);
+		for (int i = 0; i < 3; i++)
+			xyz[i] = xyz[i] > 0.008856f ? std::cbrt(xyz[i]) : 7.787f * xyz[i] + 16.0f / 116.0f;
+		return glm::vec3(116.0f * xyz.y - 16.0f, 500.0f * (xyz.x - xyz.y), 200.0f * (xyz.y - xyz.z));
+	}
+
+	// maps HDR radiance to a displayable value (Reinhard + gamma) so it can be compared perceptually
+	static glm::vec3 displayHdr(const float *p)
+	{
+		glm::vec3 c(std::max(p[0], 0.0f), std::max(p[1], 0.0f), std::max(p[2], 0.0f));
+		c = c / (c + glm::vec3(1.0f));
+		return glm::pow(c, glm::vec3(1.0f / 2.2f));
+	}
+
+	static void accumulate(Comparison &result, double deltaE)
+	{
+		result.meanDeltaE += deltaE;
+		result.maxDeltaE = std::max(result.maxDeltaE, deltaE);
+		if (deltaE > PIXEL_DELTA_E)
+			result.badFraction += 1.0;
+	}
+
+	static Comparison compareLdr(const unsigned char *current, const unsigned char *golden, int pixels, unsigned char *heatMap)
+	{
+		Comparison result = { 0.0, 0.0, 0.0 };
+		for (int i = 0; i < pixels; i++)
+		{
+			const unsigned char *a = current + i * 3;
+			const unsigned char *b = golden + i * 3;
+			if (a[0] == b[0] && a[1] == b[1] && a[2] == b[2])
+			{
+				heatMap[i * 3] = heatMap[i * 3 + 1] = heatMap[i * 3 + 2] = 0;
+				continue;
+			}
+			double deltaE = glm::length(toLab(glm::vec3(a[0], a[1], a[2]) / 255.0f) - toLab(glm::vec3(b[0], b[1], b[2]) / 255.0f));
+			accumulate(result, deltaE);
+			unsigned char v = (unsigned char)std::min(255.0, deltaE * 25.0);
+			heatMap[i * 3] = v;
+			heatMap[i * 3 + 1] = deltaE > PIXEL_DELTA_E ? 0 : v;
+			heatMap[i * 3 + 2] = 0;
+		}
+		result.meanDeltaE /= pixels;
+		result.badFraction /= pixels;
+		return result;
+	}
+
+	static Comparison compareHdr(const float *current, const float *golden, int pixels)
+	{
+		Comparison result = { 0.0, 0.0, 0.0 };
+		for (int i = 0; i < pixels; i++)
+			accumulate(result, glm::length(toLab(displayHdr(current + i * 3)) - toLab(displayHdr(golden + i * 3))));
+		result.meanDeltaE /= pixels;
+		result.badFraction /= pixels;
+		return result;
+	}
+};
+#endif
@@ -0,0 +1,198 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Measures GPU time of named regions with GL_TIMESTAMP query pairs.
+// Queries of a frame are read back FRAME_LATENCY frames later and only if the driver reports them
+// available, so reading results never stalls the pipeline. Regions may nest.
+class GpuProfiler
+{
+public:
+	static const unsigned int FRAME_LATENCY = 4;
+
+	struct Result {
+		std::string name;
+		int depth;
+		double ms;
+	};
+
+	bool enabled;
+	// print a log line every logInterval frames (0 disables logging)
+	unsigned int logInterval;
+
+	GpuProfiler(bool enabled = true, unsigned int logInterval = 120) : enabled(enabled), logInterval(logInterval), frame(0), depth(0), droppedFrames(0)
+	{
+	}
+
+	~GpuProfiler()
+	{
+		for (unsigned int i = 0; i < FRAME_LATENCY; i++)
+			if (!slots[i].queries.empty())
+				glDeleteQueries((GLsizei)slots[i].queries.size(), &slots[i].queries[0]);
+	}
+
+	// starts recording a new frame, collecting whatever finished FRAME_LATENCY frames ago
+	void beginFrame()
+	{
+		if (!enabled)
+			return;
+		FrameSlot &slot = slots[frame % FRAME_LATENCY];
+		if (!slot.regions.empty())
+			collect(slot);
+		slot.regions.clear();
+		slot.used = 0;
+		depth = 0;
+	}
+
+	void endFrame()
+	{
+		if (!enabled)
+			return;
+		frame++;
+		if (logInterval > 0 && frame % logInterval == 0)
+			log(std::cout);
+	}
+
+	// opens a region; every begin must be matched by an end in the same frame
+	void begin(const std::string &name)
+	{
+		if (!enabled)
+			return;
+		FrameSlot &slot = slots[frame % FRAME_LATENCY];
+		Region region;
+		region.name = name;
+		region.depth = depth++;
+		region.start = nextQuery(slot);
+		region.end = 0;
+		glQueryCounter(region.start, GL_TIMESTAMP);
+		slot.open.push_back(slot.regions.size());
+		slot.regions.push_back(region);
+	}
+
+	void end()
+	{
+		if (!enabled)
+			return;
+		FrameSlot &slot = slots[frame % FRAME_LATENCY];
+		if (slot.open.empty())
+			return;
+		Region &region = slot.regions[slot.open.back()];
+		slot.open.pop_back();
+		region.end = nextQuery(slot);
+		glQueryCounter(region.end, GL_TIMESTAMP);
+		depth--;
+	}
+
+	// GPU time of the named region in the most recently completed frame in milliseconds, or -1 if no result is available yet
+	double getMs(const std::string &name) const
+	{
+		std::map<std::string, double>::const_iterator it = latest.find(name);
+		return it == latest.end() ? -1.0 : it->second;
+	}
+
+	// all regions of the most recently completed frame, in submission order
+	const std::vector<Result> &getResults() const
+	{
+		return results;
+	}
+
+	// number of frames whose queries were not ready in time and had to be discarded
+	unsigned int getDroppedFrames() const
+	{
+		return droppedFrames;
+	}
+
+	void log(std::ostream &out) const
+	{
+		if (results.empty())
+			return;
+		out << "GPU:";
+		for (size_t i = 0; i < results.size(); i++)
+			out << (i ? " |" : "") << " " << std::string(results[i].depth * 2, ' ') << results[i].name << " " << results[i].ms << " ms";
+		out << std::endl;
+	}
+
+private:
+	struct Region {
+		std::string name;
+		int depth;
+		GLuint start, end;
+	};
+	struct FrameSlot {
+		std::vector<GLuint> queries;
+		size_t used = 0;
+		std::vector<Region> regions;
+		std::vector<size_t> open;
+	};
+
+	FrameSlot slots[FRAME_LATENCY];
+	unsigned int frame;
+	int depth;
+	unsigned int droppedFrames;
+	std::vector<Result> results;
+	std::map<std::string, double> latest;
+
+	GLuint nextQuery(FrameSlot &slot)
+	{
+		if (slot.used == slot.queries.size())
+		{
+			GLuint query;
+			glGenQueries(1, &query);
+			slot.queries.push_back(query);
+		}
+		return slot.queries[slot.used++];
+	}
+
+	// reads back a slot if its last query has landed; queries complete in order so that implies all of them
+	void collect(FrameSlot &slot)
+	{
+		slot.open.clear();
+		GLint available = 0;
+		glGetQueryObjectiv(slot.queries[slot.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			droppedFrames++;
+			return;
+		}
+		results.clear();
+		latest.clear();
+		for (size_t i = 0; i < slot.regions.size(); i++)
+		{
+			const Region &region = slot.regions[i];
+			if (region.end == 0)
+				continue;
+			GLuint64 start, end;
+			glGetQueryObjectui64v(region.start, GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(region.end, GL_QUERY_RESULT, &end);
+			Result result;
+			result.name = region.name;
+			result.depth = region.depth;
+			result.ms = (end - start) / 1000000.0;
+			results.push_back(result);
+			latest[region.name] += result.ms; // a region opened several times per frame accumulates
+		}
+	}
+};
+
+// RAII helper that wraps the enclosing scope in a GpuProfiler region
+class GpuScope
+{
+public:
+	GpuScope(GpuProfiler &profiler, const std::string &name) : profiler(profiler)
+	{
+		profiler.begin(name);
+	}
+	~GpuScope()
+	{
+		profiler.end();
+	}
+private:
+	GpuProfiler &profiler;
+};
+#endif
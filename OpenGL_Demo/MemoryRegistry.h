@@ -0,0 +1,200 @@
+#ifndef MEMORY_REGISTRY_H
+#define MEMORY_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Records GPU allocations (textures, render targets, vertex/index/readback/uniform buffers) and CPU-side copies of
+// mesh data with their format, dimensions, mip count and owner, and reports totals by category.
+// Sizes are estimates: drivers may pad or compress, and unsized formats are counted at 8 bits per
+// channel with RGB padded to 4 bytes per texel, which is how common drivers store them.
+// Allocation sites register explicitly; MemoryRegistry::instance() can be queried at any time.
+class MemoryRegistry
+{
+public:
+	enum Category {
+		TEXTURE,
+		RENDER_TARGET,
+		VERTEX_BUFFER,
+		INDEX_BUFFER,
+		READBACK_BUFFER,
+		UNIFORM_BUFFER,
+		CPU_MESH,
+		CATEGORY_COUNT
+	};
+
+	// GL object name spaces; a texture and a buffer may share the same id
+	enum Resource {
+		RESOURCE_TEXTURE,
+		RESOURCE_RENDERBUFFER,
+		RESOURCE_BUFFER,
+		RESOURCE_CPU
+	};
+
+	struct Allocation {
+		Category category;
+		Resource resource;
+		uintptr_t id;           // GL name, or an owner-chosen key for CPU memory
+		std::string owner;
+		GLenum format;          // internal format (0 for buffers and CPU memory)
+		int width, height;
+		int layers;             // cube faces or array layers
+		int mipLevels;
+		unsigned long long bytes;
+	};
+
+	static MemoryRegistry &instance()
+	{
+		static MemoryRegistry registry;
+		return registry;
+	}
+
+	// a texture (or texture render target) of `layers` images with `mipLevels` levels each
+	void addTexture(GLuint id, const std::string &owner, GLenum internalFormat, int width, int height, int layers = 1, int mipLevels = 1, Category category = TEXTURE)
+	{
+		Allocation a = { category, RESOURCE_TEXTURE, id, owner, internalFormat, width, height, layers, mipLevels, 0 };
+		for (int level = 0; level < mipLevels; level++)
+			a.bytes += (unsigned long long)std::max(width >> level, 1) * std::max(height >> level, 1) * bytesPerTexel(internalFormat);
+		a.bytes *= layers;
+		add(a);
+	}
+
+	void addRenderbuffer(GLuint id, const std::string &owner, GLenum internalFormat, int width, int height)
+	{
+		Allocation a = { RENDER_TARGET, RESOURCE_RENDERBUFFER, id, owner, internalFormat, width, height, 1, 1,
+			(unsigned long long)width * height * bytesPerTexel(internalFormat) };
+		add(a);
+	}
+
+	void addBuffer(GLuint id, const std::string &owner, Category category, unsigned long long bytes)
+	{
+		Allocation a = { category, RESOURCE_BUFFER, id, owner, 0, 0, 0, 1, 1, bytes };
+		add(a);
+	}
+
+	// CPU memory kept alongside a GPU resource, keyed by a caller-chosen id (re-adding replaces it)
+	void addCpu(uintptr_t id, const std::string &owner, unsigned long long bytes)
+	{
+		Allocation a = { CPU_MESH, RESOURCE_CPU, id, owner, 0, 0, 0, 1, 1, bytes };
+		add(a);
+	}
+
+	void remove(Resource resource, uintptr_t id)
+	{
+		std::map<Key, Allocation>::iterator it = allocations.find(Key(resource, id));
+		if (it == allocations.end())
+			return;
+		totals[it->second.category] -= it->second.bytes;
+		counts[it->second.category]--;
+		allocations.erase(it);
+	}
+
+	unsigned long long total(Category category) const
+	{
+		return totals[category];
+	}
+
+	unsigned long long gpuTotal() const
+	{
+		return totals[TEXTURE] + totals[RENDER_TARGET] + totals[VERTEX_BUFFER] + totals[INDEX_BUFFER] + totals[READBACK_BUFFER] + totals[UNIFORM_BUFFER];
+	}
+
+	size_t count(Category category) const
+	{
+		return counts[category];
+	}
+
+	// every live allocation, largest first
+	std::vector<Allocation> getAllocations() const
+	{
+		std::vector<Allocation> result;
+		for (std::map<Key, Allocation>::const_iterator it = allocations.begin(); it != allocations.end(); ++it)
+			result.push_back(it->second);
+		std::sort(result.begin(), result.end(), [](const Allocation &a, const Allocation &b) { return a.bytes > b.bytes; });
+		return result;
+	}
+
+	// totals by category, followed by the largest allocations
+	void log(std::ostream &out, size_t topAllocations = 10) const
+	{
+		std::ios::fmtflags flags = out.flags();
+		std::streamsize precision = out.precision();
+		out << std::fixed << std::setprecision(2) << "Memory: gpu " << mb(gpuTotal()) << " MB";
+		for (int c = 0; c < CATEGORY_COUNT; c++)
+			out << " | " << categoryName((Category)c) << " " << mb(totals[c]) << " MB (" << counts[c] << ")";
+		out << std::endl;
+		std::vector<Allocation> all = getAllocations();
+		for (size_t i = 0; i < all.size() && i < topAllocations; i++)
+		{
+			const Allocation &a = all[i];
+			out << "  " << std::setw(9) << mb(a.bytes) << " MB  " << categoryName(a.category) << " " << a.owner;
+			if (a.width > 0)
+				out << " " << a.width << "x" << a.height << (a.layers > 1 ? "x" + std::to_string(a.layers) : "")
+					<< " fmt 0x" << std::hex << a.format << std::dec << " mips " << a.mipLevels;
+			out << std::endl;
+		}
+		out.flags(flags);
+		out.precision(precision);
+	}
+
+	static const char *categoryName(Category category)
+	{
+		static const char *names[CATEGORY_COUNT] = { "textures", "render_targets", "vertex_buffers", "index_buffers", "readback_buffers", "uniform_buffers", "cpu_mesh" };
+		return names[category];
+	}
+
+	// levels of a full mip chain, as built by glGenerateMipmap
+	static int mipCount(int width, int height)
+	{
+		int levels = 1;
+		for (int size = std::max(width, height); size > 1; size >>= 1)
+			levels++;
+		return levels;
+	}
+
+	static unsigned int bytesPerTexel(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_RED: case GL_R8:
+			return 1;
+		case GL_RG: case GL_RG8: case GL_R16F:
+			return 2;
+		case GL_RGB16F: case GL_RGBA16F: case GL_RG32F:
+			return 8;
+		case GL_RGB32F: case GL_RGBA32F:
+			return 16;
+		default: // RGB/RGBA 8 bit, depth and depth-stencil formats
+			return 4;
+		}
+	}
+
+	static double mb(unsigned long long bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+private:
+	typedef std::pair<int, uintptr_t> Key;
+
+	std::map<Key, Allocation> allocations;
+	unsigned long long totals[CATEGORY_COUNT] = {};
+	size_t counts[CATEGORY_COUNT] = {};
+
+	void add(const Allocation &allocation)
+	{
+		remove(allocation.resource, allocation.id); // re-specifying an object replaces its storage
+		allocations[Key(allocation.resource, allocation.id)] = allocation;
+		totals[allocation.category] += allocation.bytes;
+		counts[allocation.category]++;
+	}
+};
+#endif
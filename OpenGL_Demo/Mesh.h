@@ -5,9 +5,15 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include "Shader.h"
+#include "MemoryRegistry.h"
+#include "PipelineState.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -28,68 +34,217 @@ struct Vertex {
 	glm::vec3 Bitangent;
 };
 
+// GPU vertex layouts a mesh can be uploaded in; the CPU side always keeps Vertex
+enum VertexFormat {
+	VERTEX_FORMAT_FLOAT,  // Vertex as is, 56 bytes
+	VERTEX_FORMAT_PACKED  // PackedVertex, 20 bytes
+};
+
+// Quantized vertex. The shader sees the same attributes as with Vertex, decoded by the normalized
+// attribute formats, except that the position is relative to the mesh: shaders/include/mesh.glsl
+// applies the offset and scale Mesh stores next to the vertices. The bitangent is not stored; it is
+// cross(normal, tangent) * tangent.w.
+struct PackedVertex {
+	int16_t Position[4];  // snorm16 of (position - bounds centre) / largest half extent; [3] unused
+	uint32_t Normal;      // snorm 10_10_10_2, w unused
+	uint32_t Tangent;     // snorm 10_10_10_2, w is the bitangent sign
+	uint32_t TexCoords;   // two half floats
+};
+
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex must stay tightly packed");
+
+// indices drawn with one call; baseVertex is added to each of them, so a 16-bit run can address
+// vertices past 65535
+struct IndexRange {
+	unsigned int first;
+	unsigned int count;
+	int baseVertex;
+};
+
 struct Texture {
 	unsigned int id;
 	string type;
 	string path;
 };
 
+// The textures of a mesh and the sampler each one feeds. Texture i is bound to unit i and named
+// after its type and rank (texture_diffuse1, texture_diffuse2, texture_specular1, ...); the names are
+// built once here. Pairing with a program resolves those names to uniform handles the first time the
+// material is drawn with it, so bind() does no string work or lookups. A program that names its
+// samplers differently (material.diffuse = 0) still gets every texture on its unit.
+class Material {
+public:
+	Material() {}
+
+	explicit Material(const vector<Texture> &textures)
+	{
+		unsigned int diffuseNr = 1;
+		unsigned int specularNr = 1;
+		unsigned int normalNr = 1;
+		unsigned int heightNr = 1;
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			Slot slot;
+			slot.texture = textures[i].id;
+			slot.sampler = textures[i].type;
+			if (slot.sampler == "texture_diffuse")
+				slot.sampler += std::to_string(diffuseNr++);
+			else if (slot.sampler == "texture_specular")
+				slot.sampler += std::to_string(specularNr++);
+			else if (slot.sampler == "texture_normal")
+				slot.sampler += std::to_string(normalNr++);
+			else if (slot.sampler == "texture_height")
+				slot.sampler += std::to_string(heightNr++);
+			slots.push_back(slot);
+		}
+	}
+
+	// binds every texture to its unit and points the program's samplers at them; `shader` must be in use
+	void bind(const Shader &shader)
+	{
+		const Pairing &pairing = pair(shader);
+		for (unsigned int i = 0; i < slots.size(); i++)
+		{
+			// sampler units are program state: this uploads only when another material moved them
+			if (pairing.samplers[i].valid())
+				shader.set(pairing.samplers[i], (int)i);
+			PipelineState::bindTexture(i, GL_TEXTURE_2D, slots[i].texture);
+		}
+	}
+
+private:
+	struct Slot {
+		unsigned int texture;
+		string sampler;
+	};
+	// the sampler handles of one program; a reloaded program has a new ID and is paired again
+	struct Pairing {
+		const Shader *shader;
+		unsigned int program;
+		vector<UniformHandle<int> > samplers;
+	};
+
+	vector<Slot> slots;
+	vector<Pairing> pairings;
+
+	const Pairing &pair(const Shader &shader)
+	{
+		for (unsigned int i = 0; i < pairings.size(); i++)
+			if (pairings[i].shader == &shader)
+			{
+				if (pairings[i].program != shader.ID)
+					resolve(pairings[i]);
+				return pairings[i];
+			}
+		Pairing pairing;
+		pairing.shader = &shader;
+		resolve(pairing);
+		pairings.push_back(pairing);
+		return pairings.back();
+	}
+
+	void resolve(Pairing &pairing) const
+	{
+		pairing.program = pairing.shader->ID;
+		pairing.samplers.clear();
+		for (unsigned int i = 0; i < slots.size(); i++)
+			pairing.samplers.push_back(pairing.shader->uniform<int>(slots[i].sampler));
+	}
+};
+
 class Mesh {
 public:
 	/*  Mesh Data  */
 	vector<Vertex> vertices;
 	vector<unsigned int> indices;
 	vector<Texture> textures;
+	Material material;
 	unsigned int VAO;
+	unsigned int indexCount;
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, and the ranges the index buffer is drawn in
+	GLenum indexType;
+	vector<IndexRange> indexRanges;
+	// object space bounding box
+	glm::vec3 boundsMin, boundsMax;
+	VertexFormat vertexFormat;
+
+	// the layout meshes are uploaded in from now on
+	static VertexFormat &defaultVertexFormat()
+	{
+		static VertexFormat format = VERTEX_FORMAT_FLOAT;
+		return format;
+	}
+
+	// whether meshes of more than 65536 vertices are split into 16-bit index ranges
+	static bool &splitIndices()
+	{
+		static bool split = true;
+		return split;
+	}
 
 	/*  Functions  */
-	// constructor
-	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+	// constructor; owner names the mesh in the memory registry
+	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, const string &owner = "mesh")
 	{
 		this->vertices = vertices;
 		this->indices = indices;
 		this->textures = textures;
+		this->material = Material(textures);
+		boundsMin = boundsMax = vertices.empty() ? glm::vec3(0.0f) : vertices[0].Position;
+		for (unsigned int i = 0; i < vertices.size(); i++)
+		{
+			boundsMin = glm::min(boundsMin, vertices[i].Position);
+			boundsMax = glm::max(boundsMax, vertices[i].Position);
+		}
 
 		// now that we have all the required data, set the vertex buffers and its attribute pointers.
-		setupMesh();
+		setupMesh(this->vertices.data(), (unsigned int)this->vertices.size(), this->indices.data(), (unsigned int)this->indices.size(), owner);
+	}
+
+	// uploads vertex and index data owned elsewhere (a mapped mesh cache entry) without keeping a CPU copy;
+	// `vertices` and `indices` stay empty
+	Mesh(const Vertex *vertexData, unsigned int vertexCount, const unsigned int *indexData, unsigned int indexCount, vector<Texture> textures,
+		const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, const string &owner = "mesh")
+		: boundsMin(boundsMin), boundsMax(boundsMax)
+	{
+		this->textures = textures;
+		this->material = Material(textures);
+		setupMesh(vertexData, vertexCount, indexData, indexCount, owner);
+	}
+
+	// deletes the GL objects and their registry entries. Copies of a Mesh share them, so only one copy
+	// releases; none of them may draw afterwards.
+	void release()
+	{
+		MemoryRegistry &memory = MemoryRegistry::instance();
+		memory.remove(MemoryRegistry::RESOURCE_BUFFER, VBO);
+		memory.remove(MemoryRegistry::RESOURCE_BUFFER, EBO);
+		memory.remove(MemoryRegistry::RESOURCE_CPU, VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		glDeleteVertexArrays(1, &VAO);
+		VAO = VBO = EBO = 0;
 	}
 
 	// render the mesh
-	void Draw(Shader shader)
+	void Draw(const Shader &shader)
 	{
 		// bind appropriate textures
-		unsigned int diffuseNr = 1;
-		unsigned int specularNr = 1;
-		unsigned int normalNr = 1;
-		unsigned int heightNr = 1;
-		for (unsigned int i = 0; i < textures.size(); i++)
+		material.bind(shader);
+
+		// draw mesh; the VAO stays bound, the next draw's pipeline or mesh rebinds only if it differs
+		PipelineState::bindVertexArray(VAO);
+		if (indexRanges.size() == 1 && indexRanges[0].baseVertex == 0)
 		{
-			glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-			// retrieve texture number (the N in diffuse_textureN)
-			string number;
-			string name = textures[i].type;
-			if (name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if (name == "texture_specular")
-				number = std::to_string(specularNr++); // transfer unsigned int to stream
-			else if (name == "texture_normal")
-				number = std::to_string(normalNr++); // transfer unsigned int to stream
-			else if (name == "texture_height")
-				number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-													 // now set the sampler to the correct texture unit
-			glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-			// and finally bind the texture
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+			return;
+		}
+		size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+		for (unsigned int i = 0; i < indexRanges.size(); i++)
+		{
+			const IndexRange &range = indexRanges[i];
+			glDrawElementsBaseVertex(GL_TRIANGLES, range.count, indexType, (void*)(range.first * indexSize), range.baseVertex);
 		}
-
-		// draw mesh
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
-
-		// always good practice to set everything back to defaults once configured.
-		glActiveTexture(GL_TEXTURE0);
 	}
 
 private:
@@ -98,25 +253,48 @@ private:
 
 	/*  Functions    */
 	// initializes all the buffer objects/arrays
-	void setupMesh()
+	void setupMesh(const Vertex *vertexData, unsigned int vertexCount, const unsigned int *indexData, unsigned int indexCount, const string &owner)
 	{
+		this->indexCount = indexCount;
+		vertexFormat = defaultVertexFormat();
+
 		// create buffers/arrays
 		glGenVertexArrays(1, &VAO);
 		glGenBuffers(1, &VBO);
 		glGenBuffers(1, &EBO);
 
-		glBindVertexArray(VAO);
+		PipelineState::bindVertexArray(VAO);
 		// load data into vertex buffers
 		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		// A great thing about structs is that their memory layout is sequential for all its items.
-		// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-		// again translates to 3/2 floats which translates to a byte array.
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+		unsigned long long vertexBytes;
+		if (vertexFormat == VERTEX_FORMAT_PACKED)
+			vertexBytes = uploadPacked(vertexData, vertexCount);
+		else
+		{
+			// A great thing about structs is that their memory layout is sequential for all its items.
+			// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+			// again translates to 3/2 floats which translates to a byte array.
+			vertexBytes = vertexCount * sizeof(Vertex);
+			glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
+		}
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		unsigned long long indexBytes = uploadIndices(indexData, indexCount, vertexCount);
+
+		// copies of a Mesh share its GL objects, so the retained CPU arrays are keyed by the VAO
+		MemoryRegistry &memory = MemoryRegistry::instance();
+		memory.addBuffer(VBO, owner, MemoryRegistry::VERTEX_BUFFER, vertexBytes);
+		memory.addBuffer(EBO, owner, MemoryRegistry::INDEX_BUFFER, indexBytes);
+		if (!vertices.empty())
+			memory.addCpu(VAO, owner, vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int));
 
 		// set the vertex attribute pointers
+		if (vertexFormat == VERTEX_FORMAT_PACKED)
+		{
+			setupPackedAttributes(vertexCount);
+			PipelineState::bindVertexArray(0);
+			return;
+		}
 		// vertex Positions
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -133,7 +311,114 @@ private:
 		glEnableVertexAttribArray(4);
 		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 
-		glBindVertexArray(0);
+		PipelineState::bindVertexArray(0);
+	}
+
+	// uploads the indices into the bound element buffer in the smallest type that addresses every vertex.
+	// With more than 65536 vertices the triangles are split, in order, into ranges whose vertices lie
+	// within 65536 of each other (cheap after MeshOptimizer's first-use vertex order), each drawn with its
+	// own base vertex; if splitting is off or a single triangle spans further, the mesh keeps 32-bit indices.
+	// Returns the bytes uploaded.
+	unsigned long long uploadIndices(const unsigned int *indexData, unsigned int indexCount, unsigned int vertexCount)
+	{
+		indexRanges.assign(1, IndexRange{ 0, indexCount, 0 });
+		if (vertexCount > 65536 && !(splitIndices() && splitRanges(indexData, indexCount)))
+		{
+			indexType = GL_UNSIGNED_INT;
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
+			return indexCount * sizeof(unsigned int);
+		}
+		indexType = GL_UNSIGNED_SHORT;
+		vector<uint16_t> shortIndices(indexCount);
+		for (unsigned int r = 0; r < indexRanges.size(); r++)
+		{
+			const IndexRange &range = indexRanges[r];
+			for (unsigned int i = range.first; i < range.first + range.count; i++)
+				shortIndices[i] = (uint16_t)(indexData[i] - range.baseVertex);
+		}
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+		return indexCount * sizeof(uint16_t);
+	}
+
+	// greedy split of the triangle list into 16-bit ranges; false (ranges untouched) if a triangle
+	// alone spans more than 65536 vertices
+	bool splitRanges(const unsigned int *indexData, unsigned int indexCount)
+	{
+		vector<IndexRange> ranges;
+		IndexRange range = { 0, 0, 0 };
+		unsigned int low = 0, high = 0;
+		for (unsigned int t = 0; t + 3 <= indexCount; t += 3)
+		{
+			unsigned int triangleLow = std::min(indexData[t], std::min(indexData[t + 1], indexData[t + 2]));
+			unsigned int triangleHigh = std::max(indexData[t], std::max(indexData[t + 1], indexData[t + 2]));
+			if (triangleHigh - triangleLow > 65535)
+				return false;
+			if (range.count > 0 && std::max(high, triangleHigh) - std::min(low, triangleLow) > 65535)
+			{
+				range.baseVertex = (int)low;
+				ranges.push_back(range);
+				range.first = t;
+				range.count = 0;
+			}
+			low = range.count > 0 ? std::min(low, triangleLow) : triangleLow;
+			high = range.count > 0 ? std::max(high, triangleHigh) : triangleHigh;
+			range.count += 3;
+		}
+		range.baseVertex = (int)low;
+		ranges.push_back(range);
+		indexRanges.swap(ranges);
+		return true;
+	}
+
+	// quantizes the vertices into the bound array buffer, followed by the position offset and scale;
+	// returns the bytes uploaded
+	unsigned long long uploadPacked(const Vertex *vertexData, unsigned int vertexCount)
+	{
+		// one scale for all axes keeps the quantization from shearing normals
+		glm::vec3 centre = (boundsMin + boundsMax) * 0.5f;
+		glm::vec3 halfExtent = (boundsMax - boundsMin) * 0.5f;
+		float scale = std::max(std::max(halfExtent.x, halfExtent.y), halfExtent.z);
+		if (scale <= 0.0f)
+			scale = 1.0f;
+
+		vector<PackedVertex> packed(vertexCount);
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			const Vertex &v = vertexData[i];
+			glm::vec3 position = (v.Position - centre) / scale;
+			uint64_t position16 = glm::packSnorm4x16(glm::vec4(position, 0.0f));
+			std::memcpy(packed[i].Position, &position16, sizeof(packed[i].Position));
+			packed[i].Normal = glm::packSnorm3x10_1x2(glm::vec4(v.Normal, 0.0f));
+			float handedness = glm::dot(glm::cross(v.Normal, v.Tangent), v.Bitangent) < 0.0f ? -1.0f : 1.0f;
+			packed[i].Tangent = glm::packSnorm3x10_1x2(glm::vec4(v.Tangent, handedness));
+			packed[i].TexCoords = glm::packHalf2x16(v.TexCoords);
+		}
+		glm::vec4 dequantize(centre, scale);
+		unsigned long long vertexBytes = vertexCount * sizeof(PackedVertex);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes + sizeof(dequantize), NULL, GL_STATIC_DRAW);
+		if (vertexCount > 0)
+			glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, &packed[0]);
+		glBufferSubData(GL_ARRAY_BUFFER, vertexBytes, sizeof(dequantize), &dequantize[0]);
+		return vertexBytes + sizeof(dequantize);
+	}
+
+	void setupPackedAttributes(unsigned int vertexCount)
+	{
+		// positions: snorm16, scaled back by attribute 5
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+		// normals and tangents: packed formats always have four components
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
+		// the position offset and scale: a single element after the vertices, read by every vertex
+		// through a divisor of 1, so the value lives in the VAO rather than in each program
+		glEnableVertexAttribArray(5);
+		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 0, (void*)((uintptr_t)vertexCount * sizeof(PackedVertex)));
+		glVertexAttribDivisor(5, 1);
 	}
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,405 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include "CpuProfiler.h"
+#include "Mesh.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#undef APIENTRY // glad's definition; windows.h defines the same calling convention
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A read-only memory mapping of a whole file; empty if the file cannot be opened or mapped
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string &path) : bytes(nullptr), length(0)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		mapping = NULL;
+		LARGE_INTEGER fileSize;
+		if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+			return;
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+			return;
+		bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (bytes)
+			length = (size_t)fileSize.QuadPart;
+#else
+		fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat info;
+		if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0)
+			return;
+		void *address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address == MAP_FAILED)
+			return;
+		bytes = (const unsigned char*)address;
+		length = (size_t)info.st_size;
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (bytes)
+			UnmapViewOfFile(bytes);
+		if (mapping != NULL)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+#else
+		if (bytes)
+			munmap((void*)bytes, length);
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	const unsigned char *data() const
+	{
+		return bytes;
+	}
+
+	size_t size() const
+	{
+		return length;
+	}
+
+private:
+	const unsigned char *bytes;
+	size_t length;
+#ifdef _WIN32
+	HANDLE file, mapping;
+#else
+	int fd;
+#endif
+};
+
+// On-disk cache of imported models in a compact binary format, so later runs skip Assimp and the
+// per-vertex conversion: the entry is memory-mapped and its vertex and index arrays go straight to
+// glBufferData. An entry records the FNV-1a hash of the source file's bytes and is ignored once the
+// source changes (material libraries are not hashed; delete the cache after editing one). Entries
+// written by a build with a different Vertex layout are ignored as well.
+//
+// Layout, little endian, every array aligned to 16 bytes:
+//   FileHeader
+//   MeshRecord[meshCount]
+//   per mesh: Vertex[vertexCount], uint32 index[indexCount], texture references
+//   texture reference: uint32 length + type ("texture_diffuse"), uint32 length + path relative to the model
+// init() must run once before models load; until then Model imports as before.
+class MeshCache
+{
+public:
+	struct Stats {
+		unsigned int hits = 0;
+		unsigned int misses = 0;
+		unsigned int stored = 0;
+	};
+
+	// one mesh of a mapped entry; the pointers stay valid while the Entry lives
+	struct MeshView {
+		const Vertex *vertices;
+		uint32_t vertexCount;
+		const unsigned int *indices;
+		uint32_t indexCount;
+		glm::vec3 boundsMin, boundsMax;
+		std::vector<std::pair<std::string, std::string> > textures; // type, path
+	};
+
+	// a validated, mapped cache entry
+	class Entry
+	{
+	public:
+		explicit Entry(const std::string &path) : file(path)
+		{
+		}
+
+		std::vector<MeshView> meshes;
+		MappedFile file;
+	};
+
+	static void init(const std::string &directory)
+	{
+		State &s = state();
+		s.directory = directory;
+		makeDirectory(directory);
+		s.enabled = true;
+	}
+
+	static void disable()
+	{
+		state().enabled = false;
+	}
+
+	static bool enabled()
+	{
+		return state().enabled;
+	}
+
+	static Stats &stats()
+	{
+		return state().stats;
+	}
+
+	// FNV-1a 64 over the file's bytes; false if it cannot be read
+	static bool hashFile(const std::string &path, uint64_t &hash)
+	{
+		PROFILE_ZONE("MeshCache::hashFile");
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if (!file)
+			return false;
+		hash = 14695981039346656037ull;
+		std::vector<char> buffer(1 << 16);
+		while (file)
+		{
+			file.read(&buffer[0], buffer.size());
+			hash = fnv1a(hash, &buffer[0], (size_t)file.gcount());
+		}
+		return true;
+	}
+
+	// folds an import setting into a source hash, so entries written with other settings miss
+	static uint64_t mix(uint64_t hash, uint32_t setting)
+	{
+		return fnv1a(hash, (const char*)&setting, sizeof(setting));
+	}
+
+	// maps the entry for `sourcePath`; nullptr (a miss) if there is none or it is stale or malformed
+	static std::unique_ptr<Entry> open(const std::string &sourcePath, uint64_t sourceHash)
+	{
+		PROFILE_ZONE("MeshCache::open");
+		State &s = state();
+		std::unique_ptr<Entry> entry(new Entry(path(sourcePath)));
+		if (!s.enabled || !parse(*entry, sourceHash))
+		{
+			s.stats.misses++;
+			return nullptr;
+		}
+		s.stats.hits++;
+		return entry;
+	}
+
+	// writes the imported meshes of `sourcePath`; the entry is replaced only once fully written
+	static void store(const std::string &sourcePath, uint64_t sourceHash, const std::vector<Mesh> &meshes)
+	{
+		PROFILE_ZONE("MeshCache::store");
+		State &s = state();
+		if (!s.enabled)
+			return;
+		std::vector<char> out(sizeof(FileHeader) + meshes.size() * sizeof(MeshRecord));
+		FileHeader header;
+		std::memcpy(header.magic, magic(), sizeof(header.magic));
+		header.version = VERSION;
+		header.vertexStride = sizeof(Vertex);
+		header.meshCount = (uint32_t)meshes.size();
+		header.sourceHash = sourceHash;
+		std::memcpy(&out[0], &header, sizeof(header));
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			const Mesh &mesh = meshes[i];
+			MeshRecord record;
+			record.vertexCount = (uint32_t)mesh.vertices.size();
+			record.indexCount = (uint32_t)mesh.indices.size();
+			record.textureCount = (uint32_t)mesh.textures.size();
+			record.pad = 0;
+			std::memcpy(record.boundsMin, &mesh.boundsMin[0], sizeof(record.boundsMin));
+			std::memcpy(record.boundsMax, &mesh.boundsMax[0], sizeof(record.boundsMax));
+			record.vertexOffset = append(out, mesh.vertices.empty() ? nullptr : &mesh.vertices[0], mesh.vertices.size() * sizeof(Vertex));
+			record.indexOffset = append(out, mesh.indices.empty() ? nullptr : &mesh.indices[0], mesh.indices.size() * sizeof(unsigned int));
+			record.textureOffset = append(out, nullptr, 0);
+			for (size_t t = 0; t < mesh.textures.size(); t++)
+			{
+				appendString(out, mesh.textures[t].type);
+				appendString(out, mesh.textures[t].path);
+			}
+			std::memcpy(&out[sizeof(FileHeader) + i * sizeof(MeshRecord)], &record, sizeof(record));
+		}
+
+		std::string target = path(sourcePath);
+		std::string temporary = target + ".tmp";
+		{
+			std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+			file.write(&out[0], out.size());
+			if (!file)
+			{
+				std::cout << "ERROR::MESH_CACHE::CANNOT_WRITE " << temporary << std::endl;
+				return;
+			}
+		}
+		std::remove(target.c_str());
+		if (std::rename(temporary.c_str(), target.c_str()) == 0)
+			s.stats.stored++;
+	}
+
+private:
+	static const uint32_t VERSION = 1;
+	static const size_t ALIGNMENT = 16;
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexStride; // sizeof(Vertex) of the writer
+		uint32_t meshCount;
+		uint64_t sourceHash;
+	};
+
+	// offsets are in bytes from the start of the file
+	struct MeshRecord {
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t textureOffset;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t textureCount;
+		uint32_t pad;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	struct State {
+		bool enabled = false;
+		std::string directory;
+		Stats stats;
+	};
+
+	static const char *magic()
+	{
+		return "GLMC";
+	}
+
+	static State &state()
+	{
+		static State s;
+		return s;
+	}
+
+	static uint64_t fnv1a(uint64_t hash, const char *data, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; i++)
+		{
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// entries are named by a hash of the source path, so models with the same file name do not collide
+	static std::string path(const std::string &sourcePath)
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "/%016llx.mesh", (unsigned long long)fnv1a(14695981039346656037ull, sourcePath.c_str(), sourcePath.size()));
+		return state().directory + name;
+	}
+
+	// pads `out` to the alignment, then appends `bytes` of `data`; returns the offset it was written at
+	static uint64_t append(std::vector<char> &out, const void *data, size_t bytes)
+	{
+		out.resize((out.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+		uint64_t offset = out.size();
+		out.resize(out.size() + bytes);
+		if (bytes > 0)
+			std::memcpy(&out[(size_t)offset], data, bytes);
+		return offset;
+	}
+
+	static void appendString(std::vector<char> &out, const std::string &value)
+	{
+		uint32_t length = (uint32_t)value.size();
+		out.insert(out.end(), (const char*)&length, (const char*)&length + sizeof(length));
+		out.insert(out.end(), value.begin(), value.end());
+	}
+
+	// true if `bytes` bytes at `offset` lie inside the mapping
+	static bool inside(const MappedFile &file, uint64_t offset, uint64_t bytes)
+	{
+		return offset <= file.size() && bytes <= file.size() - offset;
+	}
+
+	static bool readString(const MappedFile &file, uint64_t &offset, std::string &value)
+	{
+		uint32_t length = 0;
+		if (!inside(file, offset, sizeof(length)))
+			return false;
+		std::memcpy(&length, file.data() + offset, sizeof(length));
+		offset += sizeof(length);
+		if (!inside(file, offset, length))
+			return false;
+		value.assign((const char*)file.data() + offset, length);
+		offset += length;
+		return true;
+	}
+
+	// validates the header against this build and the source, and every record against the file size
+	static bool parse(Entry &entry, uint64_t sourceHash)
+	{
+		const MappedFile &file = entry.file;
+		FileHeader header;
+		if (!file.data() || !inside(file, 0, sizeof(header)))
+			return false;
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (std::memcmp(header.magic, magic(), sizeof(header.magic)) != 0 || header.version != VERSION
+			|| header.vertexStride != sizeof(Vertex) || header.sourceHash != sourceHash
+			|| !inside(file, sizeof(header), (uint64_t)header.meshCount * sizeof(MeshRecord)))
+			return false;
+		for (uint32_t i = 0; i < header.meshCount; i++)
+		{
+			MeshRecord record;
+			std::memcpy(&record, file.data() + sizeof(header) + i * sizeof(MeshRecord), sizeof(record));
+			if (!inside(file, record.vertexOffset, (uint64_t)record.vertexCount * sizeof(Vertex))
+				|| !inside(file, record.indexOffset, (uint64_t)record.indexCount * sizeof(unsigned int))
+				|| record.vertexOffset % ALIGNMENT != 0 || record.indexOffset % ALIGNMENT != 0)
+				return false;
+			MeshView view;
+			view.vertices = (const Vertex*)(file.data() + record.vertexOffset);
+			view.vertexCount = record.vertexCount;
+			view.indices = (const unsigned int*)(file.data() + record.indexOffset);
+			view.indexCount = record.indexCount;
+			view.boundsMin = glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]);
+			view.boundsMax = glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]);
+			uint64_t offset = record.textureOffset;
+			for (uint32_t t = 0; t < record.textureCount; t++)
+			{
+				std::pair<std::string, std::string> texture;
+				if (!readString(file, offset, texture.first) || !readString(file, offset, texture.second))
+					return false;
+				view.textures.push_back(texture);
+			}
+			entry.meshes.push_back(view);
+		}
+		return true;
+	}
+
+	static void makeDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+};
+#endif
@@ -0,0 +1,309 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include "CpuProfiler.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Post-import ordering of indexed triangle lists, in three steps:
+//   1. optimizeVertexCache: Tipsify (Sander, Nehab and Barczak 2007) reorders triangles so that
+//      vertices are reused while still in the post-transform cache.
+//   2. optimizeOverdraw: splits that order into clusters where the cache starts over and sorts
+//      the clusters outward-facing first, so occluders tend to draw before what they hide. The
+//      sort is kept only if the cache efficiency stays within `threshold` of step 1.
+//   3. optimizeVertexFetch: renumbers vertices in first-use order so vertex fetch walks memory
+//      forwards; vertices no triangle uses are dropped.
+// Results are measured with a FIFO cache of CACHE_SIZE entries: ACMR is vertex transforms per
+// triangle (0.5 is ideal for large regular meshes, 3 is no reuse), ATVR is transforms per vertex (1 is ideal).
+class MeshOptimizer
+{
+public:
+	static const unsigned int CACHE_SIZE = 16;
+
+	struct CacheStats {
+		float acmr;
+		float atvr;
+	};
+
+	// on by default; imported models and the procedural sphere check it
+	static bool &enabled()
+	{
+		static bool on = true;
+		return on;
+	}
+
+	// folded into mesh cache keys so entries written with other settings are not reused
+	static uint32_t settingsKey()
+	{
+		return enabled() ? 1u : 0u;
+	}
+
+	static CacheStats analyze(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE)
+	{
+		CacheStats stats = { 0.0f, 0.0f };
+		if (indices.empty())
+			return stats;
+		std::vector<unsigned int> cache(cacheSize, ~0u);
+		std::vector<unsigned char> used(vertexCount, 0);
+		size_t head = 0, transforms = 0, unique = 0;
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			unsigned int v = indices[i];
+			if (std::find(cache.begin(), cache.end(), v) == cache.end())
+			{
+				cache[head] = v;
+				head = (head + 1) % cacheSize;
+				transforms++;
+			}
+			if (!used[v])
+			{
+				used[v] = 1;
+				unique++;
+			}
+		}
+		stats.acmr = (float)transforms / (indices.size() / 3);
+		stats.atvr = (float)transforms / unique;
+		return stats;
+	}
+
+	// Tipsify: fans out from one vertex at a time, then continues with the candidate that is still in
+	// the cache and has few triangles left, falling back to recently used vertices at dead ends
+	static void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE)
+	{
+		PROFILE_ZONE("MeshOptimizer::optimizeVertexCache");
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0)
+			return;
+
+		// vertex -> triangles, as offsets into one array
+		std::vector<unsigned int> live(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			live[indices[i]]++;
+		std::vector<unsigned int> offsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			offsets[v + 1] = offsets[v] + live[v];
+		std::vector<unsigned int> adjacency(offsets[vertexCount]);
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++)
+			for (int k = 0; k < 3; k++)
+				adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+		std::vector<unsigned int> timestamp(vertexCount, 0);
+		std::vector<unsigned char> emitted(triangleCount, 0);
+		std::vector<unsigned int> deadEnd; // recently referenced vertices
+		std::vector<unsigned int> candidates;
+		std::vector<unsigned int> result;
+		result.reserve(triangleCount * 3);
+		unsigned int time = cacheSize + 1;
+		size_t cursor = 1;
+		long long fanning = 0;
+		while (fanning >= 0)
+		{
+			candidates.clear();
+			for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+			{
+				unsigned int t = adjacency[a];
+				if (emitted[t])
+					continue;
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int v = indices[t * 3 + k];
+					result.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+					if (time - timestamp[v] > cacheSize)
+						timestamp[v] = time++;
+				}
+				emitted[t] = 1;
+			}
+
+			// the candidate that will still be cached after its remaining triangles, oldest first
+			fanning = -1;
+			long long best = -1;
+			for (size_t c = 0; c < candidates.size(); c++)
+			{
+				unsigned int v = candidates[c];
+				if (live[v] == 0)
+					continue;
+				long long priority = 0;
+				if (time - timestamp[v] + 2 * live[v] <= cacheSize)
+					priority = time - timestamp[v];
+				if (priority > best)
+				{
+					best = priority;
+					fanning = v;
+				}
+			}
+			if (fanning < 0)
+				fanning = skipDeadEnd(live, deadEnd, cursor);
+		}
+		indices.swap(result);
+	}
+
+	// sorts the cache-ordered triangles cluster by cluster; `positions` holds vertexCount positions,
+	// `stride` floats apart
+	static void optimizeOverdraw(std::vector<unsigned int> &indices, const float *positions, size_t stride, size_t vertexCount, float threshold = 1.05f)
+	{
+		PROFILE_ZONE("MeshOptimizer::optimizeOverdraw");
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount < 2)
+			return;
+
+		// a cluster starts wherever a triangle misses the cache on all three vertices
+		std::vector<size_t> clusters;
+		std::vector<unsigned int> cache(CACHE_SIZE, ~0u);
+		size_t head = 0;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			int misses = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[t * 3 + k];
+				if (std::find(cache.begin(), cache.end(), v) == cache.end())
+				{
+					cache[head] = v;
+					head = (head + 1) % CACHE_SIZE;
+					misses++;
+				}
+			}
+			if (t == 0 || misses == 3)
+				clusters.push_back(t);
+		}
+		if (clusters.size() < 2)
+			return;
+		clusters.push_back(triangleCount);
+
+		// area weighted centroid and normal of every cluster and of the whole mesh
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		std::vector<glm::vec3> centroids(clusters.size() - 1), normals(clusters.size() - 1);
+		for (size_t c = 0; c + 1 < clusters.size(); c++)
+		{
+			glm::vec3 centroid(0.0f), normal(0.0f);
+			float area = 0.0f;
+			for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+			{
+				glm::vec3 p0 = position(positions, stride, indices[t * 3]);
+				glm::vec3 p1 = position(positions, stride, indices[t * 3 + 1]);
+				glm::vec3 p2 = position(positions, stride, indices[t * 3 + 2]);
+				glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+				float a = glm::length(n);
+				centroid += (p0 + p1 + p2) * (a / 3.0f);
+				normal += n;
+				area += a;
+			}
+			meshCentroid += centroid;
+			meshArea += area;
+			centroids[c] = area > 0.0f ? centroid / area : position(positions, stride, indices[clusters[c] * 3]);
+			float length = glm::length(normal);
+			normals[c] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+		}
+		if (meshArea <= 0.0f)
+			return;
+		meshCentroid /= meshArea;
+
+		std::vector<float> keys(clusters.size() - 1);
+		std::vector<size_t> order(clusters.size() - 1);
+		for (size_t c = 0; c < order.size(); c++)
+		{
+			keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+		std::vector<unsigned int> sorted;
+		sorted.reserve(indices.size());
+		for (size_t i = 0; i < order.size(); i++)
+			sorted.insert(sorted.end(), indices.begin() + clusters[order[i]] * 3, indices.begin() + clusters[order[i] + 1] * 3);
+		if (analyze(sorted, vertexCount).acmr <= analyze(indices, vertexCount).acmr * threshold)
+			indices.swap(sorted);
+	}
+
+	// rewrites `indices` to first-use order; returns old index -> new index (~0u for unused vertices)
+	// and the number of vertices kept, for remapVertices
+	static std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int> &indices, size_t vertexCount, size_t &keptCount)
+	{
+		std::vector<unsigned int> remap(vertexCount, ~0u);
+		keptCount = 0;
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			unsigned int &newIndex = remap[indices[i]];
+			if (newIndex == ~0u)
+				newIndex = (unsigned int)keptCount++;
+			indices[i] = newIndex;
+		}
+		return remap;
+	}
+
+	// applies a remap from optimizeVertexFetch to an array of `components` values per vertex
+	template <typename T>
+	static void remapVertices(std::vector<T> &vertices, size_t components, const std::vector<unsigned int> &remap, size_t keptCount)
+	{
+		std::vector<T> result(keptCount * components);
+		for (size_t v = 0; v < remap.size(); v++)
+			if (remap[v] != ~0u)
+				std::copy(vertices.begin() + v * components, vertices.begin() + (v + 1) * components, result.begin() + remap[v] * components);
+		vertices.swap(result);
+	}
+
+	// the whole stage for an imported mesh, with the cache efficiency before and after for log();
+	// touches no GL state, so meshes can be optimized on worker threads
+	static void optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, CacheStats &before, CacheStats &after)
+	{
+		PROFILE_ZONE("MeshOptimizer::optimize");
+		before = analyze(indices, vertices.size());
+		optimizeVertexCache(indices, vertices.size());
+		optimizeOverdraw(indices, &vertices[0].Position.x, sizeof(Vertex) / sizeof(float), vertices.size());
+		size_t keptCount = 0;
+		std::vector<unsigned int> remap = optimizeVertexFetch(indices, vertices.size(), keptCount);
+		remapVertices(vertices, 1, remap, keptCount);
+		after = analyze(indices, vertices.size());
+	}
+
+	static void log(const std::string &name, const CacheStats &before, const CacheStats &after)
+	{
+		std::ios::fmtflags flags = std::cout.flags();
+		std::streamsize precision = std::cout.precision();
+		std::cout << std::fixed << std::setprecision(3) << "Mesh optimize: " << name << " ACMR " << before.acmr << " -> " << after.acmr
+			<< ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+private:
+	static glm::vec3 position(const float *positions, size_t stride, unsigned int v)
+	{
+		const float *p = positions + (size_t)v * stride;
+		return glm::vec3(p[0], p[1], p[2]);
+	}
+
+	// a recently referenced vertex with triangles left, else the next such vertex in index order
+	static long long skipDeadEnd(const std::vector<unsigned int> &live, std::vector<unsigned int> &deadEnd, size_t &cursor)
+	{
+		while (!deadEnd.empty())
+		{
+			unsigned int v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+				return v;
+		}
+		while (cursor < live.size())
+		{
+			if (live[cursor] > 0)
+				return (long long)cursor++;
+			cursor++;
+		}
+		return -1;
+	}
+};
+#endif
@@ -0,0 +1,155 @@
+#ifndef MESH_WELDER_H
+#define MESH_WELDER_H
+
+#include "CpuProfiler.h"
+#include "Mesh.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Import-time vertex welding. Formats like OBJ index each attribute separately, so after import every
+// face corner is its own vertex. weld() merges vertices whose attributes all agree within a per-attribute
+// epsilon and rebuilds the index buffer over the survivors. Each attribute is snapped to a grid of its
+// epsilon and the snapped values are hashed, so welding is linear in the vertex count. Two values
+// within epsilon of each other but on opposite sides of a grid line stay apart; an epsilon of 0 welds
+// bit-identical values only. A merged vertex keeps the attributes of its first occurrence.
+// weld() touches no GL state and may run on any thread.
+class MeshWelder
+{
+public:
+	// absolute tolerances in model units; tangent applies to the bitangent as well
+	struct Tolerance {
+		float position = 1e-5f;
+		float normal = 1e-3f;
+		float texCoord = 1e-5f;
+		float tangent = 1e-3f;
+	};
+
+	struct Result {
+		size_t verticesBefore = 0;
+		size_t verticesAfter = 0;
+	};
+
+	static bool &enabled()
+	{
+		static bool on = true;
+		return on;
+	}
+
+	static Tolerance &tolerance()
+	{
+		static Tolerance t;
+		return t;
+	}
+
+	// folded into mesh cache keys so entries welded with other tolerances are not reused
+	static uint32_t settingsKey()
+	{
+		if (!enabled())
+			return 0;
+		const Tolerance &t = tolerance();
+		const float values[] = { t.position, t.normal, t.texCoord, t.tangent };
+		uint32_t hash = 2166136261u;
+		const unsigned char *bytes = (const unsigned char*)values;
+		for (size_t i = 0; i < sizeof(values); i++)
+		{
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+		return hash | 1u; // never 0, which stands for welding off
+	}
+
+	static Result weld(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, const Tolerance &t = tolerance())
+	{
+		PROFILE_ZONE("MeshWelder::weld");
+		Result result;
+		result.verticesBefore = vertices.size();
+
+		std::unordered_map<Key, unsigned int, KeyHash> welded;
+		welded.reserve(vertices.size());
+		std::vector<unsigned int> remap(vertices.size());
+		std::vector<Vertex> kept;
+		kept.reserve(vertices.size());
+		for (size_t v = 0; v < vertices.size(); v++)
+		{
+			const Vertex &vertex = vertices[v];
+			Key key;
+			int n = 0;
+			snap(key, n, &vertex.Position.x, 3, t.position);
+			snap(key, n, &vertex.Normal.x, 3, t.normal);
+			snap(key, n, &vertex.TexCoords.x, 2, t.texCoord);
+			snap(key, n, &vertex.Tangent.x, 3, t.tangent);
+			snap(key, n, &vertex.Bitangent.x, 3, t.tangent);
+			std::pair<std::unordered_map<Key, unsigned int, KeyHash>::iterator, bool> inserted = welded.insert(std::make_pair(key, (unsigned int)kept.size()));
+			if (inserted.second)
+				kept.push_back(vertex);
+			remap[v] = inserted.first->second;
+		}
+		for (size_t i = 0; i < indices.size(); i++)
+			indices[i] = remap[indices[i]];
+		vertices.swap(kept);
+		result.verticesAfter = vertices.size();
+		return result;
+	}
+
+	static void log(const std::string &name, const Result &result)
+	{
+		double reduction = result.verticesBefore ? 100.0 * (1.0 - (double)result.verticesAfter / result.verticesBefore) : 0.0;
+		std::ios::fmtflags flags = std::cout.flags();
+		std::streamsize precision = std::cout.precision();
+		std::cout << std::fixed << std::setprecision(1) << "Mesh weld: " << name << " vertices " << result.verticesBefore << " -> " << result.verticesAfter
+			<< " (-" << reduction << "%), vertex memory " << result.verticesBefore * sizeof(Vertex) / 1024.0 << " KB -> "
+			<< result.verticesAfter * sizeof(Vertex) / 1024.0 << " KB" << std::endl;
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+private:
+	static const int KEY_SIZE = 14; // floats in a Vertex
+
+	struct Key {
+		int64_t cells[KEY_SIZE];
+
+		bool operator==(const Key &other) const
+		{
+			return std::memcmp(cells, other.cells, sizeof(cells)) == 0;
+		}
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key &key) const
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (int i = 0; i < KEY_SIZE; i++)
+			{
+				hash ^= (uint64_t)key.cells[i];
+				hash *= 1099511628211ull;
+			}
+			return (size_t)(hash ^ (hash >> 32));
+		}
+	};
+
+	// grid cell of each component, or its bit pattern when epsilon is 0 (with -0 read as 0)
+	static void snap(Key &key, int &n, const float *values, int count, float epsilon)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (epsilon > 0.0f)
+				key.cells[n++] = (int64_t)std::floor((double)values[i] / epsilon + 0.5);
+			else
+			{
+				float value = values[i] == 0.0f ? 0.0f : values[i];
+				int32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				key.cells[n++] = bits;
+			}
+		}
+	}
+};
+#endif
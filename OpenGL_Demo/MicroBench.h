@@ -0,0 +1,139 @@
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Micro-benchmark runner for CPU-side hot paths.
+// Each case runs in isolation: an untimed setup, warmup repetitions, then timed repetitions whose
+// wall times are summarized (mean, median, stddev, min, max, p95). A case may repeat its body
+// `iterations` times per repetition to time operations too short for a single clock read; its
+// per-operation time is then reported as well.
+class MicroBench
+{
+public:
+	struct Case {
+		std::string name;
+		int iterations;                    // operations per timed repetition
+		std::function<void()> setup;       // runs once before the warmup, untimed
+		std::function<void()> body;        // the timed work
+		std::function<void()> teardown;    // runs after every repetition, untimed
+	};
+
+	struct Result {
+		std::string name;
+		int repetitions;
+		int iterations;
+		double meanMs, medianMs, stddevMs, minMs, maxMs, p95Ms;
+	};
+
+	int warmup;
+	int repetitions;
+	// only cases whose name contains this string run (empty: all)
+	std::string filter;
+	std::vector<Result> results;
+
+	MicroBench(int warmup = 3, int repetitions = 20, const std::string &filter = "") : warmup(warmup), repetitions(repetitions), filter(filter)
+	{
+	}
+
+	void add(const std::string &name, std::function<void()> body, int iterations = 1, std::function<void()> setup = nullptr, std::function<void()> teardown = nullptr)
+	{
+		Case c = { name, iterations, setup, body, teardown };
+		cases.push_back(c);
+	}
+
+	void run()
+	{
+		for (size_t i = 0; i < cases.size(); i++)
+		{
+			const Case &c = cases[i];
+			if (!filter.empty() && c.name.find(filter) == std::string::npos)
+				continue;
+			if (c.setup)
+				c.setup();
+			for (int w = 0; w < warmup; w++)
+				repeat(c);
+			std::vector<double> samples;
+			for (int r = 0; r < repetitions; r++)
+				samples.push_back(repeat(c));
+			results.push_back(summarize(c, samples));
+			print(std::cout, results.back());
+		}
+	}
+
+	bool writeJson(const std::string &path) const
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			std::cout << "ERROR::MICRO_BENCH::CANNOT_WRITE " << path << std::endl;
+			return false;
+		}
+		file << "{\n  \"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result &r = results[i];
+			file << "    {\"name\": \"" << r.name << "\", \"repetitions\": " << r.repetitions << ", \"iterations\": " << r.iterations
+				<< ", \"mean_ms\": " << r.meanMs << ", \"median_ms\": " << r.medianMs << ", \"stddev_ms\": " << r.stddevMs
+				<< ", \"min_ms\": " << r.minMs << ", \"max_ms\": " << r.maxMs << ", \"p95_ms\": " << r.p95Ms
+				<< ", \"per_op_ns\": " << r.medianMs * 1e6 / r.iterations << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		file << "  ]\n}\n";
+		std::cout << "Micro benchmarks written to " << path << std::endl;
+		return true;
+	}
+
+private:
+	std::vector<Case> cases;
+
+	static double repeat(const Case &c)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int i = 0; i < c.iterations; i++)
+			c.body();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (c.teardown)
+			c.teardown();
+		return ms;
+	}
+
+	static Result summarize(const Case &c, std::vector<double> samples)
+	{
+		Result r;
+		r.name = c.name;
+		r.repetitions = (int)samples.size();
+		r.iterations = c.iterations;
+		std::sort(samples.begin(), samples.end());
+		double sum = 0.0;
+		for (double s : samples)
+			sum += s;
+		r.meanMs = sum / samples.size();
+		double variance = 0.0;
+		for (double s : samples)
+			variance += (s - r.meanMs) * (s - r.meanMs);
+		r.stddevMs = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+		size_t n = samples.size();
+		r.medianMs = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+		r.minMs = samples.front();
+		r.maxMs = samples.back();
+		r.p95Ms = samples[std::min(n - 1, (size_t)(0.95 * n))];
+		return r;
+	}
+
+	static void print(std::ostream &out, const Result &r)
+	{
+		out << r.name << ": median " << r.medianMs << " ms | mean " << r.meanMs << " ms +- " << r.stddevMs
+			<< " | min " << r.minMs << " | max " << r.maxMs << " | p95 " << r.p95Ms;
+		if (r.iterations > 1)
+			out << " | " << r.medianMs * 1e6 / r.iterations << " ns/op";
+		out << std::endl;
+	}
+};
+#endif
@@ -11,7 +11,11 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshWelder.h"
 #include "Shader.h"
+#include "CpuProfiler.h"
 
 #include <string>
 #include <fstream>
@@ -19,6 +23,10 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
 using namespace std;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
@@ -40,17 +48,64 @@ public:
 	}
 
 	// draws the model, and thus all its meshes
-	void Draw(Shader shader)
+	void Draw(const Shader &shader)
 	{
 		for (unsigned int i = 0; i < meshes.size(); i++)
 			meshes[i].Draw(shader);
 	}
 
+	// deletes the meshes' GL objects and the textures the model loaded; the model is empty afterwards.
+	// Without it they live until the context goes away.
+	void release()
+	{
+		for (unsigned int i = 0; i < meshes.size(); i++)
+			meshes[i].release();
+		for (unsigned int i = 0; i < textures_loaded.size(); i++)
+		{
+			MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_TEXTURE, textures_loaded[i].id);
+			glDeleteTextures(1, &textures_loaded[i].id);
+		}
+		meshes.clear();
+		textures_loaded.clear();
+		PipelineState::invalidate(); // deleted names may be handed out again
+	}
+
 private:
+	// a mesh as imported, before upload: welding and optimization work on this on worker threads
+	struct ImportedMesh {
+		string name;
+		vector<Vertex> vertices;
+		vector<unsigned int> indices;
+		vector<Texture> textures;
+		bool triangles;
+		MeshWelder::Result weld;
+		bool optimized = false;
+		MeshOptimizer::CacheStats before, after;
+	};
+
 	/*  Functions   */
 	// loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+	// With the mesh cache on, a current cache entry replaces the import, and an import writes one.
 	void loadModel(string const &path)
 	{
+		PROFILE_ZONE("Model::loadModel");
+		// retrieve the directory path of the filepath
+		directory = path.substr(0, path.find_last_of('/'));
+
+		uint64_t sourceHash = 0;
+		bool cacheable = MeshCache::enabled() && MeshCache::hashFile(path, sourceHash);
+		sourceHash = MeshCache::mix(sourceHash, MeshWelder::settingsKey());
+		sourceHash = MeshCache::mix(sourceHash, MeshOptimizer::settingsKey());
+		if (cacheable)
+		{
+			std::unique_ptr<MeshCache::Entry> entry = MeshCache::open(path, sourceHash);
+			if (entry)
+			{
+				loadCached(*entry);
+				return;
+			}
+		}
+
 		// read file via ASSIMP
 		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -60,15 +115,41 @@ private:
 			cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
 			return;
 		}
-		// retrieve the directory path of the filepath
-		directory = path.substr(0, path.find_last_of('/'));
 
 		// process ASSIMP's root node recursively
-		processNode(scene->mRootNode, scene);
+		vector<ImportedMesh> imported;
+		processNode(scene->mRootNode, scene, imported);
+		// weld and optimize all meshes in parallel, then upload them in order on this (the GL) thread
+		parallelFor(imported.size(), [&imported](size_t i) { prepareMesh(imported[i]); });
+		for (unsigned int i = 0; i < imported.size(); i++)
+		{
+			ImportedMesh &mesh = imported[i];
+			if (mesh.weld.verticesBefore > 0)
+				MeshWelder::log(mesh.name, mesh.weld);
+			if (mesh.optimized)
+				MeshOptimizer::log(mesh.name, mesh.before, mesh.after);
+			meshes.push_back(Mesh(mesh.vertices, mesh.indices, mesh.textures, directory));
+		}
+		if (cacheable)
+			MeshCache::store(path, sourceHash, meshes);
+	}
+
+	// uploads every mesh of a mapped cache entry straight from the mapping
+	void loadCached(const MeshCache::Entry &entry)
+	{
+		PROFILE_ZONE("Model::loadCached");
+		for (unsigned int i = 0; i < entry.meshes.size(); i++)
+		{
+			const MeshCache::MeshView &view = entry.meshes[i];
+			vector<Texture> textures;
+			for (unsigned int t = 0; t < view.textures.size(); t++)
+				textures.push_back(loadTexture(view.textures[t].second.c_str(), view.textures[t].first));
+			meshes.push_back(Mesh(view.vertices, view.vertexCount, view.indices, view.indexCount, textures, view.boundsMin, view.boundsMax, directory));
+		}
 	}
 
 	// processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-	void processNode(aiNode *node, const aiScene *scene)
+	void processNode(aiNode *node, const aiScene *scene, vector<ImportedMesh> &imported)
 	{
 		// process each mesh located at the current node
 		for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -76,22 +157,27 @@ private:
 			// the node object only contains indices to index the actual objects in the scene. 
 			// the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			meshes.push_back(processMesh(mesh, scene));
+			imported.push_back(processMesh(mesh, scene));
 		}
 		// after we've processed all of the meshes (if any) we then recursively process each of the children nodes
 		for (unsigned int i = 0; i < node->mNumChildren; i++)
 		{
-			processNode(node->mChildren[i], scene);
+			processNode(node->mChildren[i], scene, imported);
 		}
 
 	}
 
-	Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+	// copies a mesh out of the assimp scene and loads its textures (which needs the GL thread)
+	ImportedMesh processMesh(aiMesh *mesh, const aiScene *scene)
 	{
+		PROFILE_ZONE("Model::processMesh");
 		// data to fill
-		vector<Vertex> vertices;
-		vector<unsigned int> indices;
-		vector<Texture> textures;
+		ImportedMesh result;
+		result.name = directory + "/" + mesh->mName.C_Str();
+		result.triangles = mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE;
+		vector<Vertex> &vertices = result.vertices;
+		vector<unsigned int> &indices = result.indices;
+		vector<Texture> &textures = result.textures;
 
 		// Walk through each of the mesh's vertices
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -162,8 +248,39 @@ private:
 		std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
 		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-		// return a mesh object created from the extracted mesh data
-		return Mesh(vertices, indices, textures);
+		return result;
+	}
+
+	// merges duplicate vertices, then reorders triangles and vertices for the vertex cache, overdraw
+	// and vertex fetch; no GL calls, runs on a worker thread
+	static void prepareMesh(ImportedMesh &mesh)
+	{
+		if (!mesh.triangles || mesh.vertices.empty())
+			return;
+		if (MeshWelder::enabled())
+			mesh.weld = MeshWelder::weld(mesh.vertices, mesh.indices);
+		if (MeshOptimizer::enabled())
+		{
+			MeshOptimizer::optimize(mesh.vertices, mesh.indices, mesh.before, mesh.after);
+			mesh.optimized = true;
+		}
+	}
+
+	// runs job(0) .. job(count - 1) on up to one thread per core, the calling thread included
+	static void parallelFor(size_t count, const std::function<void(size_t)> &job)
+	{
+		size_t workers = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+		std::atomic<size_t> next(0);
+		auto run = [&]() {
+			for (size_t i = next++; i < count; i = next++)
+				job(i);
+		};
+		vector<std::thread> threads;
+		for (size_t w = 1; w < workers; w++)
+			threads.push_back(std::thread(run));
+		run();
+		for (size_t w = 0; w < threads.size(); w++)
+			threads[w].join();
 	}
 
 	// checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -175,34 +292,34 @@ private:
 		{
 			aiString str;
 			mat->GetTexture(type, i, &str);
-			// check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-			bool skip = false;
-			for (unsigned int j = 0; j < textures_loaded.size(); j++)
-			{
-				if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-				{
-					textures.push_back(textures_loaded[j]);
-					skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-					break;
-				}
-			}
-			if (!skip)
-			{   // if texture hasn't been loaded already, load it
-				Texture texture;
-				texture.id = TextureFromFile(str.C_Str(), this->directory);
-				texture.type = typeName;
-				texture.path = str.C_Str();
-				textures.push_back(texture);
-				textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-			}
+			textures.push_back(loadTexture(str.C_Str(), typeName));
 		}
 		return textures;
 	}
+
+	// the texture at `path` (relative to the model), loaded once per model
+	Texture loadTexture(const char *path, const string &typeName)
+	{
+		// check if texture was loaded before and if so, reuse it instead of loading a new texture
+		for (unsigned int j = 0; j < textures_loaded.size(); j++)
+		{
+			if (std::strcmp(textures_loaded[j].path.data(), path) == 0)
+				return textures_loaded[j]; // a texture with the same filepath has already been loaded (optimization)
+		}
+		// if texture hasn't been loaded already, load it
+		Texture texture;
+		texture.id = TextureFromFile(path, this->directory);
+		texture.type = typeName;
+		texture.path = path;
+		textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+		return texture;
+	}
 };
 
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
 {
+	PROFILE_ZONE("TextureFromFile");
 	string filename = string(path);
 	filename = directory + '/' + filename;
 
@@ -224,6 +341,7 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
 		glBindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
+		MemoryRegistry::instance().addTexture(textureID, filename, format, width, height, 1, MemoryRegistry::mipCount(width, height));
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
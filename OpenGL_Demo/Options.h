@@ -0,0 +1,171 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Command line options of the demo. With no arguments the demo opens a window and runs until it is closed.
+struct RunOptions
+{
+	// headless benchmark mode: offscreen context, fixed number of frames, timing report
+	bool headless = false;
+	int frames = 500;
+	int warmup = 50;
+	std::string jsonPath = "frame_stats.json";
+	// per-pass GPU timings, logged every gpuProfileInterval frames
+	bool gpuProfile = false;
+	int gpuProfileInterval = 120;
+	// CPU zone trace written on exit (empty: profiler disabled)
+	std::string cpuTracePath;
+	// golden-image regression: render fixed camera poses and compare (or update) stored images
+	bool golden = false;
+	bool updateGolden = false;
+	std::string goldenDir = "./golden";
+	double goldenTolerance = 0.001;
+	// GL call counters and redundant state detection, logged every glStatsInterval frames
+	bool glStats = false;
+	int glStatsInterval = 120;
+	// camera path recording / deterministic replay with a fixed simulated clock
+	std::string recordPath;
+	std::string replayPath;
+	// fixed time step of a recording (and of captured video); a replay uses the step stored in the path
+	float replayDeltaTime = 1.0f / 60.0f;
+	// CPU-side micro-benchmarks instead of the render loop
+	bool microBench = false;
+	std::string benchFilter;
+	int benchWarmup = 3;
+	int benchRepetitions = 20;
+	std::string benchJsonPath = "micro_bench.json";
+	// on-screen performance overlay (implies GL stats and GPU pass timings, without their console logs)
+	bool hud = false;
+	// asynchronous capture of every rendered frame into captureDir as png, y4m or raw
+	std::string captureDir;
+	std::string captureFormat = "png";
+	// linked program binaries cached on disk between runs
+	bool shaderCache = true;
+	std::string shaderCacheDir = "./shader_cache";
+	// rebuild programs whose sources change on disk (windowed runs, Linux inotify)
+	bool shaderHotReload = true;
+	// imported models cached on disk in a binary format that is memory-mapped on later runs
+	bool meshCache = true;
+	std::string meshCacheDir = "./mesh_cache";
+	// GPU vertex layout of loaded meshes: "float" (56 bytes) or "packed" (20 bytes, quantized)
+	std::string vertexFormat = "float";
+	// reorder mesh triangles and vertices for the post-transform cache, overdraw and vertex fetch
+	bool meshOptimize = true;
+	// merge duplicate vertices of imported meshes; weldEpsilon overrides the tolerances as
+	// "position,normal,texcoord,tangent" (empty: MeshWelder defaults)
+	bool meshWeld = true;
+	std::string weldEpsilon;
+	// meshes over 65536 vertices are drawn as 16-bit index ranges with a base vertex each;
+	// off keeps them 32-bit (smaller meshes always use 16-bit indices)
+	bool splitIndices = true;
+};
+
+// parses argv into a RunOptions struct. Unknown arguments are reported and ignored.
+// ------------------------------------------------------------------------
+inline RunOptions parseOptions(int argc, char **argv)
+{
+	RunOptions options;
+	bool deltaTimeGiven = false;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--headless") == 0)
+			options.headless = true;
+		else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+			options.frames = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue)
+			options.warmup = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--json") == 0 && hasValue)
+			options.jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--gpu-profile") == 0)
+			options.gpuProfile = true;
+		else if (std::strcmp(argv[i], "--gpu-profile-interval") == 0 && hasValue)
+			options.gpuProfileInterval = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--cpu-trace") == 0 && hasValue)
+			options.cpuTracePath = argv[++i];
+		else if (std::strcmp(argv[i], "--golden") == 0)
+			options.golden = true;
+		else if (std::strcmp(argv[i], "--update-golden") == 0)
+			options.golden = options.updateGolden = true;
+		else if (std::strcmp(argv[i], "--golden-dir") == 0 && hasValue)
+			options.goldenDir = argv[++i];
+		else if (std::strcmp(argv[i], "--golden-tolerance") == 0 && hasValue)
+			options.goldenTolerance = std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--gl-stats") == 0)
+			options.glStats = true;
+		else if (std::strcmp(argv[i], "--gl-stats-interval") == 0 && hasValue)
+			options.glStatsInterval = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--record") == 0 && hasValue)
+			options.recordPath = argv[++i];
+		else if (std::strcmp(argv[i], "--replay") == 0 && hasValue)
+			options.replayPath = argv[++i];
+		else if (std::strcmp(argv[i], "--replay-dt") == 0 && hasValue)
+		{
+			options.replayDeltaTime = (float)std::atof(argv[++i]);
+			deltaTimeGiven = true;
+		}
+		else if (std::strcmp(argv[i], "--micro-bench") == 0)
+			options.microBench = true;
+		else if (std::strcmp(argv[i], "--bench-filter") == 0 && hasValue)
+			options.benchFilter = argv[++i];
+		else if (std::strcmp(argv[i], "--bench-warmup") == 0 && hasValue)
+			options.benchWarmup = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--bench-reps") == 0 && hasValue)
+			options.benchRepetitions = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--bench-json") == 0 && hasValue)
+			options.benchJsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--hud") == 0)
+			options.hud = true;
+		else if (std::strcmp(argv[i], "--capture") == 0 && hasValue)
+			options.captureDir = argv[++i];
+		else if (std::strcmp(argv[i], "--capture-format") == 0 && hasValue)
+			options.captureFormat = argv[++i];
+		else if (std::strcmp(argv[i], "--shader-cache") == 0 && hasValue)
+			options.shaderCacheDir = argv[++i];
+		else if (std::strcmp(argv[i], "--no-shader-cache") == 0)
+			options.shaderCache = false;
+		else if (std::strcmp(argv[i], "--no-hot-reload") == 0)
+			options.shaderHotReload = false;
+		else if (std::strcmp(argv[i], "--mesh-cache") == 0 && hasValue)
+			options.meshCacheDir = argv[++i];
+		else if (std::strcmp(argv[i], "--no-mesh-cache") == 0)
+			options.meshCache = false;
+		else if (std::strcmp(argv[i], "--vertex-format") == 0 && hasValue)
+			options.vertexFormat = argv[++i];
+		else if (std::strcmp(argv[i], "--no-mesh-optimize") == 0)
+			options.meshOptimize = false;
+		else if (std::strcmp(argv[i], "--no-mesh-weld") == 0)
+			options.meshWeld = false;
+		else if (std::strcmp(argv[i], "--weld-epsilon") == 0 && hasValue)
+			options.weldEpsilon = argv[++i];
+		else if (std::strcmp(argv[i], "--no-index-split") == 0)
+			options.splitIndices = false;
+		else
+			std::cout << "Unknown argument: " << argv[i] << std::endl;
+	}
+	// golden runs and micro-benchmarks always render offscreen
+	if (options.golden || options.microBench)
+		options.headless = true;
+	if (options.frames < 1)
+		options.frames = 1;
+	if (options.warmup < 0)
+		options.warmup = 0;
+	if (options.gpuProfileInterval < 0)
+		options.gpuProfileInterval = 0;
+	if (options.benchWarmup < 0)
+		options.benchWarmup = 0;
+	if (options.benchRepetitions < 1)
+		options.benchRepetitions = 1;
+	if (deltaTimeGiven && !options.replayPath.empty())
+		std::cout << "WARNING::OPTIONS::REPLAY_DT_IGNORED --replay-dt applies to recording; a replay runs at the time step stored in " << options.replayPath << std::endl;
+	if (options.replayDeltaTime <= 0.0f)
+		options.replayDeltaTime = 1.0f / 60.0f;
+	if (options.glStatsInterval < 0)
+		options.glStatsInterval = 0;
+	return options;
+}
+#endif
@@ -0,0 +1,241 @@
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <glad/glad.h>
+
+#include "GLStats.h"
+#include "GpuProfiler.h"
+#include "MemoryRegistry.h"
+#include "PipelineState.h"
+#include "Shader.h"
+#include "stb_easy_font.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// On-screen performance overlay: frame time graph, p99 over the graph window, draw calls and
+// triangles of the last frame (GLStats), memory totals (MemoryRegistry) and per-pass GPU times (GpuProfiler).
+// Text comes from stb_easy_font, which emits quads; text, graph bars and the background are batched
+// into one stream vertex buffer and drawn with a single indexed draw call per frame.
+// stb_easy_font.h defines globals, so include this header from one translation unit only.
+class PerfHud
+{
+public:
+	// frames kept for the graph and the percentile window
+	static const int HISTORY = 240;
+	static const int MAX_QUADS = 8192;
+
+	// HUD pixels to framebuffer pixels
+	float scale;
+	// frame time at the top of the graph, and the budget line drawn across it
+	float graphMaxMs;
+	float budgetMs;
+
+	PerfHud() : scale(2.0f), graphMaxMs(33.3f), budgetMs(16.7f), shader("./shaders/vertexshader/hud.vs", "./shaders/fragmentshader/hud.fs"),
+		vertices(MAX_QUADS * 4), used(0), frameTimes(HISTORY, 0.0f), head(0), count(0), started(false), cpuMs(0.0)
+	{
+		// stb_easy_font emits quads; one static index buffer turns every quad into two triangles
+		std::vector<unsigned short> indices(MAX_QUADS * 6);
+		for (int q = 0; q < MAX_QUADS; q++)
+		{
+			unsigned short v = (unsigned short)(q * 4);
+			unsigned short quad[6] = { v, (unsigned short)(v + 1), (unsigned short)(v + 2), v, (unsigned short)(v + 2), (unsigned short)(v + 3) };
+			std::copy(quad, quad + 6, &indices[q * 6]);
+		}
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, MAX_QUADS * 4 * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0], GL_STATIC_DRAW);
+		// layout written by stb_easy_font: float x, y, z, unsigned char color[4]
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		glBindVertexArray(0);
+		// drawn over the finished frame: no depth test, alpha blended
+		RasterState overlay;
+		overlay.depthTest = false;
+		overlay.blend = true;
+		pipeline.reset(new PipelineState(shader, VAO, overlay));
+		MemoryRegistry::instance().addBuffer(VBO, "hud", MemoryRegistry::VERTEX_BUFFER, MAX_QUADS * 4 * sizeof(Vertex));
+		MemoryRegistry::instance().addBuffer(EBO, "hud", MemoryRegistry::INDEX_BUFFER, indices.size() * sizeof(unsigned short));
+	}
+
+	~PerfHud()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_BUFFER, VBO);
+		MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_BUFFER, EBO);
+		glDeleteProgram(shader.ID);
+	}
+
+	// call once per frame; the wall time between calls is the frame time shown
+	void beginFrame()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (started)
+			addFrameTime((float)std::chrono::duration<double, std::milli>(now - lastFrame).count());
+		started = true;
+		lastFrame = now;
+	}
+
+	void addFrameTime(float ms)
+	{
+		frameTimes[head] = ms;
+		head = (head + 1) % HISTORY;
+		if (count < HISTORY)
+			count++;
+	}
+
+	// nearest-rank percentile of the frame times in the window
+	float percentile(float p)
+	{
+		if (count == 0)
+			return 0.0f;
+		sorted.assign(frameTimes.begin(), frameTimes.begin() + count);
+		size_t rank = std::min((size_t)count - 1, (size_t)(p / 100.0f * count));
+		std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+		return sorted[rank];
+	}
+
+	// builds the overlay and draws it over the bound framebuffer; depth test is disabled meanwhile
+	void render(int width, int height, GpuProfiler &gpuProfiler, const GLStats &glStats)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		gpuProfiler.begin("hud");
+		used = 0;
+
+		const float x = 8.0f;
+		const float lineHeight = 12.0f;
+		const float graphWidth = (float)HISTORY;
+		const float graphHeight = 60.0f;
+		int lines = 7 + (int)gpuProfiler.getResults().size();
+		rect(0.0f, 0.0f, graphWidth + 2.0f * x, graphHeight + lines * lineHeight + 3.0f * x, 0, 0, 0, 160);
+		graph(x, x, graphWidth, graphHeight);
+
+		char line[128];
+		float y = graphHeight + 2.0f * x;
+		float current = count > 0 ? frameTimes[(head + HISTORY - 1) % HISTORY] : 0.0f;
+		std::snprintf(line, sizeof(line), "frame %.2f ms (%.0f fps)  p99 %.2f ms", current, current > 0.0f ? 1000.0f / current : 0.0f, percentile(99.0f));
+		text(x, y, line, 255, 255, 255);
+		y += lineHeight;
+		if (glStats.isInstalled())
+		{
+			const GLStats::FrameCounters &counters = glStats.getLastFrame();
+			std::snprintf(line, sizeof(line), "draws %llu  tris %llu  gl calls %llu", counters.drawCalls, counters.triangles, counters.calls);
+		}
+		else
+			std::snprintf(line, sizeof(line), "draws n/a (GL stats not installed)");
+		text(x, y, line, 255, 255, 255);
+		y += lineHeight;
+		std::snprintf(line, sizeof(line), "uniforms %llu issued  %llu skipped", Shader::uploadStats().lastIssued, Shader::uploadStats().lastSkipped);
+		text(x, y, line, 255, 255, 255);
+		y += lineHeight;
+		const MemoryRegistry &memory = MemoryRegistry::instance();
+		std::snprintf(line, sizeof(line), "mem tex %.1f MB  rt %.1f MB  buf %.1f MB  cpu mesh %.1f MB",
+			MemoryRegistry::mb(memory.total(MemoryRegistry::TEXTURE)), MemoryRegistry::mb(memory.total(MemoryRegistry::RENDER_TARGET)),
+			MemoryRegistry::mb(memory.total(MemoryRegistry::VERTEX_BUFFER) + memory.total(MemoryRegistry::INDEX_BUFFER)),
+			MemoryRegistry::mb(memory.total(MemoryRegistry::CPU_MESH)));
+		text(x, y, line, 255, 255, 255);
+		y += lineHeight;
+		std::snprintf(line, sizeof(line), "hud cpu %.3f ms  gpu %.3f ms", cpuMs, std::max(0.0, gpuProfiler.getMs("hud")));
+		text(x, y, line, 160, 160, 160);
+		y += lineHeight * 1.5f;
+		const std::vector<GpuProfiler::Result> &passes = gpuProfiler.getResults();
+		for (size_t i = 0; i < passes.size(); i++)
+		{
+			std::snprintf(line, sizeof(line), "%*s%-12s %6.3f ms", passes[i].depth * 2, "", passes[i].name.c_str(), passes[i].ms);
+			text(x, y, line, 180, 220, 255);
+			y += lineHeight;
+		}
+
+		draw(width, height);
+		gpuProfiler.end();
+		cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	struct Vertex {
+		float x, y, z;
+		unsigned char color[4];
+	};
+
+	Shader shader;
+	unsigned int VAO, VBO, EBO;
+	std::unique_ptr<PipelineState> pipeline;
+	std::vector<Vertex> vertices; // fixed capacity batch, the first `used` entries are filled
+	size_t used;
+	std::vector<float> frameTimes; // ring buffer
+	std::vector<float> sorted;     // scratch for percentile
+	int head;
+	int count;
+	bool started;
+	std::chrono::steady_clock::time_point lastFrame;
+	double cpuMs;
+
+	void rect(float x, float y, float w, float h, unsigned char r, unsigned char g, unsigned char b, unsigned char a = 255)
+	{
+		if (used + 4 > vertices.size())
+			return;
+		Vertex corners[4] = {
+			{ x, y, 0.0f, { r, g, b, a } },
+			{ x + w, y, 0.0f, { r, g, b, a } },
+			{ x + w, y + h, 0.0f, { r, g, b, a } },
+			{ x, y + h, 0.0f, { r, g, b, a } }
+		};
+		std::copy(corners, corners + 4, &vertices[used]);
+		used += 4;
+	}
+
+	void text(float x, float y, const char *str, unsigned char r, unsigned char g, unsigned char b)
+	{
+		unsigned char color[4] = { r, g, b, 255 };
+		if (used == vertices.size())
+			return;
+		int quads = stb_easy_font_print(x, y, (char*)str, color, &vertices[used], (int)((vertices.size() - used) * sizeof(Vertex)));
+		used += quads * 4;
+	}
+
+	// one bar per frame in the window, oldest on the left; green within budget, yellow up to twice, red above
+	void graph(float x, float y, float w, float h)
+	{
+		rect(x, y, w, h, 40, 40, 40, 200);
+		for (int i = 0; i < count; i++)
+		{
+			float ms = frameTimes[(head - count + i + HISTORY) % HISTORY];
+			float barHeight = std::min(ms / graphMaxMs, 1.0f) * h;
+			if (ms <= budgetMs)
+				rect(x + i, y + h - barHeight, 1.0f, barHeight, 60, 200, 60);
+			else if (ms <= 2.0f * budgetMs)
+				rect(x + i, y + h - barHeight, 1.0f, barHeight, 230, 200, 40);
+			else
+				rect(x + i, y + h - barHeight, 1.0f, barHeight, 230, 50, 50);
+		}
+		float budgetY = y + h - std::min(budgetMs / graphMaxMs, 1.0f) * h;
+		rect(x, budgetY, w, 1.0f, 255, 255, 255, 120);
+	}
+
+	// uploads the batch into freshly orphaned storage and issues the single draw
+	void draw(int width, int height)
+	{
+		if (used == 0 || !shader.ready())
+			return; // the overlay appears once its program has compiled
+		pipeline->apply();
+		shader.setVec2("screenSize", (float)width, (float)height);
+		shader.setFloat("scale", scale);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, MAX_QUADS * 4 * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, used * sizeof(Vertex), &vertices[0]);
+		glDrawElements(GL_TRIANGLES, (GLsizei)(used / 4 * 6), GL_UNSIGNED_SHORT, 0);
+	}
+};
+#endif
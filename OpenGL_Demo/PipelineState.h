@@ -0,0 +1,234 @@
+#ifndef PIPELINE_STATE_H
+#define PIPELINE_STATE_H
+
+#include <glad/glad.h>
+
+#include "Shader.h"
+
+#include <vector>
+
+// depth, blend and cull state of a pipeline; the blend function only matters while blending is on
+struct RasterState {
+	bool depthTest = true;
+	GLenum depthFunc = GL_LESS;
+	bool depthWrite = true;
+	bool blend = false;
+	GLenum blendSrc = GL_SRC_ALPHA;
+	GLenum blendDst = GL_ONE_MINUS_SRC_ALPHA;
+	bool cull = false;
+	GLenum cullFace = GL_BACK;
+};
+
+// a texture a pipeline binds by default, e.g. the skybox cubemap on unit 0
+struct TextureBinding {
+	GLuint unit;
+	GLenum target;
+	GLuint texture;
+};
+
+// Immutable bundle of the state one pass draws with: program, vertex array, raster state and default
+// texture bindings. apply() compares each piece against the state the last apply (or tracked bind)
+// left behind and issues only the calls that change something, so switching between pipelines that
+// share most of their state is cheap, and the calls issued and skipped are counted per frame.
+// A vertex array of 0 leaves the binding to the draw, as meshes bind their own VAO; in GL 3.3 the VAO
+// is both the vertex format and its buffers. Code that changes the same state directly must call
+// invalidate() before the next apply, which then sets everything once.
+class PipelineState
+{
+public:
+	// state calls issued and skipped as already current, summed over all pipelines
+	struct Stats {
+		unsigned long long applies = 0;
+		unsigned long long issued = 0;
+		unsigned long long skipped = 0;
+		// counts of the previous frame
+		unsigned long long lastApplies = 0;
+		unsigned long long lastIssued = 0;
+		unsigned long long lastSkipped = 0;
+
+		void endFrame()
+		{
+			lastApplies = applies;
+			lastIssued = issued;
+			lastSkipped = skipped;
+			applies = issued = skipped = 0;
+		}
+	};
+
+	PipelineState(const Shader &shader, GLuint vertexArray = 0, const RasterState &raster = RasterState(),
+		const std::vector<TextureBinding> &textures = std::vector<TextureBinding>())
+		: shader(&shader), vertexArray(vertexArray), raster(raster), textures(textures)
+	{
+	}
+
+	const Shader &program() const
+	{
+		return *shader;
+	}
+
+	// makes this pipeline current; the program's uniforms can be set right after
+	void apply() const
+	{
+		stats().applies++;
+		shader->finish();
+		useProgram(shader->ID);
+		if (vertexArray != 0)
+			bindVertexArray(vertexArray);
+		setCapability(GL_DEPTH_TEST, raster.depthTest, current().depthTest);
+		if (raster.depthTest)
+			setDepthFunc(raster.depthFunc);
+		setDepthMask(raster.depthWrite);
+		setCapability(GL_BLEND, raster.blend, current().blend);
+		if (raster.blend)
+			setBlendFunc(raster.blendSrc, raster.blendDst);
+		setCapability(GL_CULL_FACE, raster.cull, current().cull);
+		if (raster.cull)
+			setCullFace(raster.cullFace);
+		for (size_t i = 0; i < textures.size(); i++)
+			bindTexture(textures[i].unit, textures[i].target, textures[i].texture);
+	}
+
+	// tracked binds for state a draw sets on its own (mesh VAOs and material textures)
+	// ------------------------------------------------------------------------
+	static void useProgram(GLuint program)
+	{
+		if (changed(Shader::currentProgram(), program))
+			glUseProgram(program);
+	}
+
+	static void bindVertexArray(GLuint vertexArray)
+	{
+		if (changed(current().vertexArray, vertexArray))
+			glBindVertexArray(vertexArray);
+	}
+
+	static void bindTexture(GLuint unit, GLenum target, GLuint texture)
+	{
+		GLuint *bound = unit < MAX_UNITS ? current().textureSlot(unit, target) : nullptr;
+		if (bound && *bound == texture)
+		{
+			stats().skipped++;
+			return;
+		}
+		if (changed(current().activeTexture, GL_TEXTURE0 + unit))
+			glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		stats().issued++;
+		if (bound)
+			*bound = texture;
+	}
+
+	// forgets the tracked state; the next apply sets everything
+	static void invalidate()
+	{
+		current() = Current();
+		Shader::currentProgram() = UNKNOWN;
+	}
+
+	static Stats &stats()
+	{
+		static Stats s;
+		return s;
+	}
+
+private:
+	static const GLuint UNKNOWN = 0xFFFFFFFFu;
+	static const GLuint MAX_UNITS = 16;
+
+	// the state GL is known to be in; UNKNOWN until a tracked call sets it. The program is tracked by
+	// Shader, so Shader::use() and apply() agree on it.
+	struct Current {
+		GLuint vertexArray = UNKNOWN;
+		GLuint activeTexture = UNKNOWN;
+		GLuint depthTest = UNKNOWN, depthFunc = UNKNOWN, depthWrite = UNKNOWN;
+		GLuint blend = UNKNOWN, blendSrc = UNKNOWN, blendDst = UNKNOWN;
+		GLuint cull = UNKNOWN, cullFace = UNKNOWN;
+		GLuint texture2D[MAX_UNITS];
+		GLuint textureCube[MAX_UNITS];
+
+		Current()
+		{
+			for (GLuint i = 0; i < MAX_UNITS; i++)
+				texture2D[i] = textureCube[i] = UNKNOWN;
+		}
+
+		// other targets are not tracked and always bound
+		GLuint *textureSlot(GLuint unit, GLenum target)
+		{
+			if (target == GL_TEXTURE_2D)
+				return &texture2D[unit];
+			if (target == GL_TEXTURE_CUBE_MAP)
+				return &textureCube[unit];
+			return nullptr;
+		}
+	};
+
+	const Shader *shader;
+	GLuint vertexArray;
+	RasterState raster;
+	std::vector<TextureBinding> textures;
+
+	static Current &current()
+	{
+		static Current c;
+		return c;
+	}
+
+	// records `value` as current; true if it differs, so the caller issues the call
+	static bool changed(GLuint &tracked, GLuint value)
+	{
+		if (tracked == value)
+		{
+			stats().skipped++;
+			return false;
+		}
+		tracked = value;
+		stats().issued++;
+		return true;
+	}
+
+	static void setCapability(GLenum capability, bool enable, GLuint &tracked)
+	{
+		if (changed(tracked, enable ? 1u : 0u))
+		{
+			if (enable)
+				glEnable(capability);
+			else
+				glDisable(capability);
+		}
+	}
+
+	static void setDepthFunc(GLenum func)
+	{
+		if (changed(current().depthFunc, func))
+			glDepthFunc(func);
+	}
+
+	static void setDepthMask(bool write)
+	{
+		if (changed(current().depthWrite, write ? 1u : 0u))
+			glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+
+	static void setBlendFunc(GLenum src, GLenum dst)
+	{
+		// both factors go up in one call, so they are tracked as a pair
+		bool srcChanged = current().blendSrc != src, dstChanged = current().blendDst != dst;
+		if (!srcChanged && !dstChanged)
+		{
+			stats().skipped++;
+			return;
+		}
+		current().blendSrc = src;
+		current().blendDst = dst;
+		stats().issued++;
+		glBlendFunc(src, dst);
+	}
+
+	static void setCullFace(GLenum face)
+	{
+		if (changed(current().cullFace, face))
+			glCullFace(face);
+	}
+};
+#endif
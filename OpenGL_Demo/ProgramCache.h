@@ -0,0 +1,275 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// ARB_get_program_binary (core in GL 4.1); the loader is generated for 3.3 core without extensions
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// whether the current context advertises the named extension
+inline bool hasGLExtension(const char *name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++)
+	{
+		const GLubyte *extension = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if (extension && std::strcmp((const char*)extension, name) == 0)
+			return true;
+	}
+	return false;
+}
+
+// On-disk cache of linked program binaries. An entry is keyed by a hash of every source stage and
+// the driver's vendor, renderer and version strings, so a driver update or an edited shader misses
+// instead of loading a stale binary. A binary the driver refuses is reported as rejected and the
+// caller compiles from source as usual; the fresh binary then replaces the entry.
+// init() must run once after the context is current; until then every call is a no-op that misses.
+class ProgramCache
+{
+public:
+	struct Stats {
+		unsigned int hits = 0;
+		unsigned int misses = 0;
+		unsigned int rejected = 0; // entries found but refused by glProgramBinary
+		unsigned int stored = 0;
+	};
+
+	// loads the entry points and checks for at least one binary format; false if binaries are unsupported
+	static bool init(GLADloadproc load, const std::string &directory)
+	{
+		State &s = state();
+		s.enabled = false;
+		s.getProgramBinary = (GetProgramBinaryProc)load("glGetProgramBinary");
+		s.programBinary = (ProgramBinaryProc)load("glProgramBinary");
+		s.programParameteri = (ProgramParameteriProc)load("glProgramParameteri");
+		if (!s.getProgramBinary || !s.programBinary || !s.programParameteri || !hasExtension())
+		{
+			std::cout << "Program cache: disabled, ARB_get_program_binary is not available" << std::endl;
+			return false;
+		}
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		if (formats < 1)
+		{
+			std::cout << "Program cache: disabled, the driver exposes no program binary format" << std::endl;
+			return false;
+		}
+		s.directory = directory;
+		makeDirectory(directory);
+		s.driver = string(GL_VENDOR) + "|" + string(GL_RENDERER) + "|" + string(GL_VERSION) + "|" + string(GL_SHADING_LANGUAGE_VERSION);
+		s.enabled = true;
+		return true;
+	}
+
+	static bool enabled()
+	{
+		return state().enabled;
+	}
+
+	static Stats &stats()
+	{
+		return state().stats;
+	}
+
+	// FNV-1a 64 over the driver identification and every stage, each terminated so stage boundaries count
+	static uint64_t key(const std::vector<std::string> &sources)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		hash = fnv1a(hash, state().driver.c_str(), state().driver.size() + 1);
+		for (size_t i = 0; i < sources.size(); i++)
+			hash = fnv1a(hash, sources[i].c_str(), sources[i].size() + 1);
+		return hash;
+	}
+
+	// must be called before glLinkProgram on a program that will be stored
+	static void prepare(GLuint program)
+	{
+		if (enabled())
+			state().programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	// hands the cached binary to the driver; true if one was found. The driver may validate it
+	// asynchronously, so whether it was accepted is only known from verify().
+	static bool load(uint64_t key, GLuint program)
+	{
+		State &s = state();
+		if (!s.enabled)
+			return false;
+		std::ifstream file(path(key).c_str(), std::ios::binary);
+		Header header = {};
+		if (!file || !file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, magic(), sizeof(header.magic)) != 0 || header.key != key)
+		{
+			s.stats.misses++;
+			return false;
+		}
+		// a corrupt length must not size the allocation: it has to fit in what the file holds
+		std::streamoff binaryStart = file.tellg();
+		file.seekg(0, std::ios::end);
+		std::streamoff available = file.tellg() - binaryStart;
+		file.seekg(binaryStart);
+		if (header.length == 0 || (std::streamoff)header.length > available)
+		{
+			s.stats.misses++;
+			return false;
+		}
+		std::vector<char> binary(header.length);
+		if (!file.read(&binary[0], header.length))
+		{
+			s.stats.misses++;
+			return false;
+		}
+		s.programBinary(program, header.format, &binary[0], (GLsizei)header.length);
+		return true;
+	}
+
+	// true if the binary given to load() linked; a rejected binary counts as a miss
+	static bool verify(GLuint program)
+	{
+		State &s = state();
+		GLint linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked)
+		{
+			s.stats.rejected++;
+			s.stats.misses++;
+			return false;
+		}
+		s.stats.hits++;
+		return true;
+	}
+
+	// writes the binary of a successfully linked program; the file is replaced only once fully written
+	static void store(uint64_t key, GLuint program)
+	{
+		State &s = state();
+		if (!s.enabled)
+			return;
+		GLint linked = 0, length = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (!linked || length <= 0)
+			return;
+		std::vector<char> binary(length);
+		Header header = {}; // zeroed, so the padding written to disk is deterministic
+		std::memcpy(header.magic, magic(), sizeof(header.magic));
+		header.key = key;
+		GLsizei written = 0;
+		s.getProgramBinary(program, length, &written, &header.format, &binary[0]);
+		header.length = (uint32_t)written;
+		if (written <= 0)
+			return;
+
+		std::string target = path(key);
+		std::string temporary = target + ".tmp";
+		{
+			std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+			file.write((const char*)&header, sizeof(header));
+			file.write(&binary[0], written);
+			if (!file)
+			{
+				std::cout << "ERROR::PROGRAM_CACHE::CANNOT_WRITE " << temporary << std::endl;
+				return;
+			}
+		}
+		std::remove(target.c_str());
+		if (std::rename(temporary.c_str(), target.c_str()) == 0)
+			s.stats.stored++;
+	}
+
+private:
+	typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+	typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+	typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+	struct Header {
+		char magic[4];
+		GLenum format;
+		uint64_t key;
+		uint32_t length;
+	};
+
+	struct State {
+		bool enabled = false;
+		std::string directory;
+		std::string driver;
+		GetProgramBinaryProc getProgramBinary = nullptr;
+		ProgramBinaryProc programBinary = nullptr;
+		ProgramParameteriProc programParameteri = nullptr;
+		Stats stats;
+	};
+
+	static const char *magic()
+	{
+		return "GLPB";
+	}
+
+	static State &state()
+	{
+		static State s;
+		return s;
+	}
+
+	static uint64_t fnv1a(uint64_t hash, const char *data, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; i++)
+		{
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static std::string path(uint64_t key)
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+		return state().directory + name;
+	}
+
+	static std::string string(GLenum name)
+	{
+		const GLubyte *value = glGetString(name);
+		return value ? (const char*)value : "";
+	}
+
+	// core since 4.1, otherwise advertised as an extension
+	static bool hasExtension()
+	{
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		return major > 4 || (major == 4 && minor >= 1) || hasGLExtension("GL_ARB_get_program_binary");
+	}
+
+	static void makeDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+};
+#endif
@@ -4,19 +4,90 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "CpuProfiler.h"
+#include "ProgramCache.h"
+#include "stb_include.h"
+
 #include <string>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// uniform buffer binding points of the blocks shared by all programs (see FrameUniforms.h)
+enum UniformBlockBinding {
+	CAMERA_BLOCK_BINDING = 0,
+	LIGHTS_BLOCK_BINDING = 1
+};
+
+// a uniform resolved once by name; setting it through Shader::set skips the name lookup entirely
+template <typename T>
+struct UniformHandle
+{
+	GLint location = -1;
+	int index = -1; // entry in the owning Shader's reflected uniform table
+
+	bool valid() const
+	{
+		return location >= 0;
+	}
+	// whether a uniform declared with the given GLSL type can be set from a T
+	static bool accepts(GLenum type);
+};
+
+template <> inline bool UniformHandle<int>::accepts(GLenum type)
+{
+	return type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE || type == GL_SAMPLER_3D || type == GL_SAMPLER_2D_SHADOW;
+}
+template <> inline bool UniformHandle<float>::accepts(GLenum type)
+{
+	return type == GL_FLOAT;
+}
+template <> inline bool UniformHandle<glm::vec2>::accepts(GLenum type)
+{
+	return type == GL_FLOAT_VEC2;
+}
+template <> inline bool UniformHandle<glm::vec3>::accepts(GLenum type)
+{
+	return type == GL_FLOAT_VEC3;
+}
+template <> inline bool UniformHandle<glm::vec4>::accepts(GLenum type)
+{
+	return type == GL_FLOAT_VEC4;
+}
+template <> inline bool UniformHandle<glm::mat3>::accepts(GLenum type)
+{
+	return type == GL_FLOAT_MAT3;
+}
+template <> inline bool UniformHandle<glm::mat4>::accepts(GLenum type)
+{
+	return type == GL_FLOAT_MAT4;
+}
+
 class Shader
 {
 public:
 	unsigned int ID;
-	// constructor generates the shader on the fly
+	// constructor generates the shader on the fly. Every stage is preprocessed first: #include "file"
+	// is expanded from shaders/include, and globalDefines() plus `defines` replace the #inject line
+	// (or follow #version when there is none)
 	// ------------------------------------------------------------------------
-	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const std::string &defines = std::string())
+		: defines(defines)
 	{
+		PROFILE_ZONE("Shader::Shader");
+		paths.push_back(vertexPath);
+		paths.push_back(fragmentPath);
+		if (geometryPath != nullptr)
+			paths.push_back(geometryPath);
 		// 1. retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
 		std::string fragmentCode;
@@ -57,114 +128,482 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
-		const char* vShaderCode = vertexCode.c_str();
-		const char * fShaderCode = fragmentCode.c_str();
-		// 2. compile shaders
-		unsigned int vertex, fragment;
-		// vertex shader
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vShaderCode, NULL);
-		glCompileShader(vertex);
-		checkCompileErrors(vertex, "VERTEX");
-		// fragment Shader
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fShaderCode, NULL);
-		glCompileShader(fragment);
-		checkCompileErrors(fragment, "FRAGMENT");
-		// if geometry shader is given, compile geometry shader
-		unsigned int geometry;
+		vertexCode = preprocess(vertexCode, vertexPath);
+		fragmentCode = preprocess(fragmentCode, fragmentPath);
 		if (geometryPath != nullptr)
-		{
-			const char * gShaderCode = geometryCode.c_str();
-			geometry = glCreateShader(GL_GEOMETRY_SHADER);
-			glShaderSource(geometry, 1, &gShaderCode, NULL);
-			glCompileShader(geometry);
-			checkCompileErrors(geometry, "GEOMETRY");
-		}
-		// shader Program
+			geometryCode = preprocess(geometryCode, geometryPath);
+		// 2. submit the program without asking for any status, so a driver that compiles on other
+		// threads keeps working after the constructor returns; finish() collects the result on first use
+		hasGeometry = geometryPath != nullptr;
+		stageSources[0] = vertexCode;
+		stageSources[1] = fragmentCode;
+		stageSources[2] = geometryCode;
+		cacheKey = ProgramCache::key(std::vector<std::string>(stageSources, stageSources + 3));
 		ID = glCreateProgram();
-		glAttachShader(ID, vertex);
-		glAttachShader(ID, fragment);
-		if (geometryPath != nullptr)
-			glAttachShader(ID, geometry);
-		glLinkProgram(ID);
-		checkCompileErrors(ID, "PROGRAM");
-		// delete the shaders as they're linked into our program now and no longer necessery
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
-		if (geometryPath != nullptr)
-			glDeleteShader(geometry);
-
+		if (ProgramCache::load(cacheKey, ID))
+			status = STATUS_PENDING_BINARY;
+		else
+			submitSources();
 	}
-	// activate the shader
+	// activate the shader; the first call waits for the program to finish compiling. Skipped when the
+	// program is already current, as tracked together with PipelineState.
 	// ------------------------------------------------------------------------
 	void use()
 	{
-		glUseProgram(ID);
+		finish();
+		if (currentProgram() != ID)
+		{
+			glUseProgram(ID);
+			currentProgram() = ID;
+		}
+	}
+	// the program the last use() or PipelineState apply made current; 0xFFFFFFFF when unknown
+	// ------------------------------------------------------------------------
+	static GLuint &currentProgram()
+	{
+		static GLuint program = 0xFFFFFFFFu;
+		return program;
+	}
+	// true once use() no longer waits for the compiler. Only drivers with KHR_parallel_shader_compile
+	// can tell without blocking; elsewhere this is always true and the first use() waits.
+	// ------------------------------------------------------------------------
+	bool ready() const
+	{
+		if (status == STATUS_READY || !parallelCompile())
+			return true;
+		GLint done = 0;
+		glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+		return done != 0;
+	}
+	// collects the compile and link status, stores the binary and builds the uniform table.
+	// Called by use(); a cached binary the driver refuses is linked from source here instead.
+	// ------------------------------------------------------------------------
+	void finish() const
+	{
+		if (status == STATUS_READY)
+			return;
+		PROFILE_ZONE("Shader::finish");
+		if (status == STATUS_PENDING_BINARY && !ProgramCache::verify(ID))
+			submitSources();
+		if (status == STATUS_PENDING_SOURCE)
+		{
+			checkCompileErrors(stages[0], "VERTEX");
+			checkCompileErrors(stages[1], "FRAGMENT");
+			if (hasGeometry)
+				checkCompileErrors(stages[2], "GEOMETRY");
+			checkCompileErrors(ID, "PROGRAM");
+			// delete the shaders as they're linked into our program now and no longer necessery
+			glDeleteShader(stages[0]);
+			glDeleteShader(stages[1]);
+			if (hasGeometry)
+				glDeleteShader(stages[2]);
+			ProgramCache::store(cacheKey, ID);
+		}
+		GLint linkStatus = 0;
+		glGetProgramiv(ID, GL_LINK_STATUS, &linkStatus);
+		linkedOk = linkStatus != 0;
+		status = STATUS_READY;
+		for (int i = 0; i < 3; i++)
+			std::string().swap(stageSources[i]);
+		reflectUniforms();
+		bindUniformBlocks();
+	}
+	// whether the program linked; waits for it like use() does
+	// ------------------------------------------------------------------------
+	bool linked() const
+	{
+		finish();
+		return linkedOk;
+	}
+	// the files the program was built from, vertex, fragment and geometry (if any) in that order
+	const std::vector<std::string> &sourcePaths() const
+	{
+		return paths;
+	}
+	// the variant defines the program was built with
+	const std::string &sourceDefines() const
+	{
+		return defines;
+	}
+	// defines injected into every program built after they are set, e.g. sizes shared with C++ code
+	static std::string &globalDefines()
+	{
+		static std::string globals;
+		return globals;
+	}
+	// takes over the program of `other` (used by hot reload); `other` is left holding this one's old
+	// program for the caller to delete. Uniform values are not carried over.
+	// ------------------------------------------------------------------------
+	void swapProgram(Shader &other)
+	{
+		finish();
+		other.finish();
+		std::swap(ID, other.ID);
+		std::swap(linkedOk, other.linkedOk);
+		if (currentProgram() == other.ID)
+			currentProgram() = 0xFFFFFFFFu; // the old program is about to be deleted and its name reused
+		uniforms.swap(other.uniforms);
+		uniformIndex.swap(other.uniformIndex);
+	}
+	// lets the driver compile on its own threads (KHR or ARB_parallel_shader_compile), which also makes
+	// ready() non-blocking. Call once after loading GL; false if neither extension is available.
+	// ------------------------------------------------------------------------
+	static bool enableParallelCompile(GLADloadproc load)
+	{
+		typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+		MaxShaderCompilerThreadsProc maxShaderCompilerThreads = nullptr;
+		if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+			maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsKHR");
+		else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+			maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsARB");
+		if (!maxShaderCompilerThreads)
+			return false;
+		maxShaderCompilerThreads(0xFFFFFFFF); // as many threads as the implementation wants
+		parallelCompileFlag() = true;
+		return true;
+	}
+	static bool parallelCompile()
+	{
+		return parallelCompileFlag();
 	}
-	// utility uniform functions
+	// utility uniform functions; names resolve through the table built at link time, not the driver,
+	// and a value equal to the one last uploaded is not uploaded again
 	// ------------------------------------------------------------------------
 	void setBool(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		setInt(name, (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		int index = uniformSlot(name);
+		if (shadow(index, &value, sizeof(value)))
+			glUniform1i(uniforms[index].location, value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		int index = uniformSlot(name);
+		if (shadow(index, &value, sizeof(value)))
+			glUniform1f(uniforms[index].location, value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		int index = uniformSlot(name);
+		if (shadow(index, &value[0], sizeof(value)))
+			glUniform2fv(uniforms[index].location, 1, &value[0]);
 	}
 	void setVec2(const std::string &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+		setVec2(name, glm::vec2(x, y));
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		int index = uniformSlot(name);
+		if (shadow(index, &value[0], sizeof(value)))
+			glUniform3fv(uniforms[index].location, 1, &value[0]);
 	}
 	void setVec3(const std::string &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		setVec3(name, glm::vec3(x, y, z));
 	}
 	// ------------------------------------------------------------------------
 	void setVec4(const std::string &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		int index = uniformSlot(name);
+		if (shadow(index, &value[0], sizeof(value)))
+			glUniform4fv(uniforms[index].location, 1, &value[0]);
 	}
-	void setVec4(const std::string &name, float x, float y, float z, float w)
+	void setVec4(const std::string &name, float x, float y, float z, float w) const
 	{
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+		setVec4(name, glm::vec4(x, y, z, w));
 	}
 	// ------------------------------------------------------------------------
 	void setMat2(const std::string &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		int index = uniformSlot(name);
+		if (shadow(index, &mat[0][0], sizeof(mat)))
+			glUniformMatrix2fv(uniforms[index].location, 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat3(const std::string &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		int index = uniformSlot(name);
+		if (shadow(index, &mat[0][0], sizeof(mat)))
+			glUniformMatrix3fv(uniforms[index].location, 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat4(const std::string &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		int index = uniformSlot(name);
+		if (shadow(index, &mat[0][0], sizeof(mat)))
+			glUniformMatrix4fv(uniforms[index].location, 1, GL_FALSE, &mat[0][0]);
+	}
+
+	// typed uniform handles: resolve a name once, then set it without any lookup
+	// ------------------------------------------------------------------------
+	template <typename T>
+	UniformHandle<T> uniform(const std::string &name) const
+	{
+		UniformHandle<T> handle;
+		finish();
+		int index = uniformSlot(name);
+		if (index < 0)
+			return handle;
+		const UniformInfo &info = uniforms[index];
+		if (!UniformHandle<T>::accepts(info.type))
+		{
+			std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH " << name << " is declared as 0x" << std::hex << info.type << std::dec << std::endl;
+			return handle;
+		}
+		handle.location = info.location;
+		handle.index = index;
+		return handle;
+	}
+	void set(UniformHandle<int> handle, int value) const
+	{
+		if (shadow(handle.index, &value, sizeof(value)))
+			glUniform1i(handle.location, value);
+	}
+	void set(UniformHandle<float> handle, float value) const
+	{
+		if (shadow(handle.index, &value, sizeof(value)))
+			glUniform1f(handle.location, value);
+	}
+	void set(UniformHandle<glm::vec2> handle, const glm::vec2 &value) const
+	{
+		if (shadow(handle.index, &value[0], sizeof(value)))
+			glUniform2fv(handle.location, 1, &value[0]);
+	}
+	void set(UniformHandle<glm::vec3> handle, const glm::vec3 &value) const
+	{
+		if (shadow(handle.index, &value[0], sizeof(value)))
+			glUniform3fv(handle.location, 1, &value[0]);
+	}
+	void set(UniformHandle<glm::vec4> handle, const glm::vec4 &value) const
+	{
+		if (shadow(handle.index, &value[0], sizeof(value)))
+			glUniform4fv(handle.location, 1, &value[0]);
+	}
+	void set(UniformHandle<glm::mat3> handle, const glm::mat3 &mat) const
+	{
+		if (shadow(handle.index, &mat[0][0], sizeof(mat)))
+			glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+	}
+	void set(UniformHandle<glm::mat4> handle, const glm::mat4 &mat) const
+	{
+		if (shadow(handle.index, &mat[0][0], sizeof(mat)))
+			glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+	}
+
+	// uniform uploads issued and skipped as unchanged, summed over all programs
+	struct UploadStats {
+		unsigned long long issued = 0;
+		unsigned long long skipped = 0;
+		// counts of the previous frame
+		unsigned long long lastIssued = 0;
+		unsigned long long lastSkipped = 0;
+
+		void endFrame()
+		{
+			lastIssued = issued;
+			lastSkipped = skipped;
+			issued = skipped = 0;
+		}
+	};
+	static UploadStats &uploadStats()
+	{
+		static UploadStats stats;
+		return stats;
+	}
+
+	// location of an active uniform, -1 for names the program does not use
+	GLint uniformLocation(const std::string &name) const
+	{
+		finish();
+		int index = uniformSlot(name);
+		return index < 0 ? -1 : uniforms[index].location;
 	}
 
 private:
+	struct UniformInfo {
+		GLint location;
+		GLenum type;
+		// shadow of the value last uploaded; uniforms must only be set through this class
+		bool known;
+		float value[16];
+	};
+	// mutable: the setters are const but keep the shadow values up to date
+	mutable std::vector<UniformInfo> uniforms;
+	mutable std::unordered_map<std::string, int> uniformIndex;
+
+	// construction completes lazily in finish(), which may run from const members
+	enum Status {
+		STATUS_PENDING_SOURCE,
+		STATUS_PENDING_BINARY,
+		STATUS_READY
+	};
+	mutable Status status;
+	mutable unsigned int stages[3];        // vertex, fragment, geometry shader objects until the link is checked
+	mutable std::string stageSources[3];   // kept in case a cached binary is refused
+	bool hasGeometry;
+	uint64_t cacheKey;
+	mutable bool linkedOk;
+	std::vector<std::string> paths;
+	std::string defines;
+
+	static bool &parallelCompileFlag()
+	{
+		static bool enabled = false;
+		return enabled;
+	}
+
+	int uniformSlot(const std::string &name) const
+	{
+		std::unordered_map<std::string, int>::const_iterator it = uniformIndex.find(name);
+		return it == uniformIndex.end() ? -1 : it->second;
+	}
+
+	// records an upload of `bytes` at `value`; false if the uniform is unknown or already holds that value
+	bool shadow(int index, const void *value, size_t bytes) const
+	{
+		if (index < 0)
+			return false;
+		UniformInfo &info = uniforms[index];
+		if (info.known && std::memcmp(info.value, value, bytes) == 0)
+		{
+			uploadStats().skipped++;
+			return false;
+		}
+		std::memcpy(info.value, value, bytes);
+		info.known = true;
+		uploadStats().issued++;
+		return true;
+	}
+
+	// expands includes and injects the defines through stb_include. A source with no #inject line has
+	// its #version line replaced by one and re-emitted ahead of the defines, so line numbers in compiler
+	// messages still match the file
+	// ------------------------------------------------------------------------
+	std::string preprocess(const std::string &source, const char *path) const
+	{
+		std::string text = source;
+		std::string inject = globalDefines() + defines;
+		if (text.compare(0, 7, "#inject") != 0 && text.find("\n#inject") == std::string::npos)
+		{
+			size_t versionEnd = text.compare(0, 8, "#version") == 0 ? text.find('\n') : 0;
+			if (versionEnd == std::string::npos)
+				versionEnd = text.size();
+			inject = text.substr(0, versionEnd) + "\n" + inject;
+			text = "#inject" + text.substr(versionEnd);
+		}
+		char error[256] = "";
+		char *expanded = stb_include_string(&text[0], &inject[0], (char*)"./shaders/include", (char*)path, error);
+		if (expanded == NULL)
+		{
+			std::cout << "ERROR::SHADER::INCLUDE_FAILED " << path << ": " << error << std::endl;
+			return source;
+		}
+		std::string result(expanded);
+		free(expanded);
+		return result;
+	}
+
+	// 3. compiles the stages and links them into ID without waiting for the result
+	// ------------------------------------------------------------------------
+	void submitSources() const
+	{
+		const char* vShaderCode = stageSources[0].c_str();
+		const char * fShaderCode = stageSources[1].c_str();
+		// vertex shader
+		stages[0] = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(stages[0], 1, &vShaderCode, NULL);
+		glCompileShader(stages[0]);
+		// fragment Shader
+		stages[1] = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(stages[1], 1, &fShaderCode, NULL);
+		glCompileShader(stages[1]);
+		// if geometry shader is given, compile geometry shader
+		stages[2] = 0;
+		if (hasGeometry)
+		{
+			const char * gShaderCode = stageSources[2].c_str();
+			stages[2] = glCreateShader(GL_GEOMETRY_SHADER);
+			glShaderSource(stages[2], 1, &gShaderCode, NULL);
+			glCompileShader(stages[2]);
+		}
+		// shader Program
+		glAttachShader(ID, stages[0]);
+		glAttachShader(ID, stages[1]);
+		if (hasGeometry)
+			glAttachShader(ID, stages[2]);
+		ProgramCache::prepare(ID);
+		glLinkProgram(ID);
+		status = STATUS_PENDING_SOURCE;
+	}
+
+	// builds the name -> location table from the linked program. Arrays are entered under their
+	// base name and under every element name ("lights[1]"), since element locations need not be contiguous.
+	// Relinking starts over with no known values.
+	// ------------------------------------------------------------------------
+	void reflectUniforms() const
+	{
+		uniforms.clear();
+		uniformIndex.clear();
+		GLint count = 0, maxLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		std::vector<GLchar> buffer(maxLength + 1);
+		for (GLint i = 0; i < count; i++)
+		{
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, &buffer[0]);
+			std::string name(&buffer[0], length);
+			GLint location = glGetUniformLocation(ID, name.c_str());
+			if (location < 0)
+				continue; // uniform block member
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			{
+				std::string base = name.substr(0, name.size() - 3);
+				for (GLint e = 0; e < size; e++)
+				{
+					std::string element = base + "[" + std::to_string(e) + "]";
+					addUniform(element, e == 0 ? location : glGetUniformLocation(ID, element.c_str()), type);
+				}
+				// the base name aliases element 0, sharing its shadow value
+				uniformIndex[base] = uniformIndex[name];
+			}
+			else
+				addUniform(name, location, type);
+		}
+	}
+
+	// GLSL 330 has no layout(binding = N); attach the shared blocks to their binding points here
+	// ------------------------------------------------------------------------
+	void bindUniformBlocks() const
+	{
+		GLuint camera = glGetUniformBlockIndex(ID, "Camera");
+		if (camera != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, camera, CAMERA_BLOCK_BINDING);
+		GLuint lights = glGetUniformBlockIndex(ID, "Lights");
+		if (lights != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, lights, LIGHTS_BLOCK_BINDING);
+	}
+
+	void addUniform(const std::string &name, GLint location, GLenum type) const
+	{
+		UniformInfo info = { location, type, false, {} };
+		uniformIndex[name] = (int)uniforms.size();
+		uniforms.push_back(info);
+	}
+
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
-	void checkCompileErrors(GLuint shader, std::string type)
+	void checkCompileErrors(GLuint shader, std::string type) const
 	{
 		GLint success;
 		GLchar infoLog[1024];
@@ -0,0 +1,106 @@
+#ifndef SHADER_FAMILY_H
+#define SHADER_FAMILY_H
+
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Material parameters declared static: each one is baked into a variant as the compile-time constant
+// STATIC_<NAME>, which the shader uses in place of the uniform it would otherwise read. Values are
+// written with 9 significant digits, so a baked float is the same float the uniform would hold.
+class Specialization
+{
+public:
+	Specialization &set(const std::string &name, float value)
+	{
+		values[name] = literal(value);
+		return *this;
+	}
+
+	Specialization &set(const std::string &name, const glm::vec3 &value)
+	{
+		values[name] = "vec3(" + literal(value.x) + ", " + literal(value.y) + ", " + literal(value.z) + ")";
+		return *this;
+	}
+
+	// "#define STATIC_NAME value" lines, ordered by name so equal sets give equal strings
+	std::string defines() const
+	{
+		std::string result;
+		for (std::map<std::string, std::string>::const_iterator it = values.begin(); it != values.end(); ++it)
+			result += "#define STATIC_" + it->first + " " + it->second + "\n";
+		return result;
+	}
+
+private:
+	std::map<std::string, std::string> values; // name -> GLSL literal
+
+	static std::string literal(float value)
+	{
+		char text[32];
+		std::snprintf(text, sizeof(text), "%.9g", value);
+		std::string result(text);
+		if (result.find_first_of(".eni") == std::string::npos)
+			result += ".0"; // GLSL reads "64" as an int
+		return result;
+	}
+};
+
+// One pair of shader sources built as a family of variants. Feature i of the family is a
+// preprocessor symbol; the variant for a bitmask is the program compiled with the symbol of every
+// set bit defined, so each draw runs only the code paths it asked for. A variant is built on first
+// request and kept for the life of the family; its binary also goes through the program cache.
+// A variant may also be specialized: the same features with some parameters baked in as constants.
+class ShaderFamily
+{
+public:
+	ShaderFamily(const std::string &vertexPath, const std::string &fragmentPath, const std::vector<std::string> &features)
+		: vertexPath(vertexPath), fragmentPath(fragmentPath), features(features)
+	{
+	}
+
+	~ShaderFamily()
+	{
+		for (std::map<Key, std::unique_ptr<Shader> >::iterator it = variants.begin(); it != variants.end(); ++it)
+			glDeleteProgram(it->second->ID);
+	}
+
+	// the program for a feature mask and set of baked constants; the first request submits it for compilation
+	Shader &variant(unsigned int mask, const Specialization &constants = Specialization())
+	{
+		std::string constantDefines = constants.defines();
+		std::unique_ptr<Shader> &shader = variants[Key(mask, constantDefines)];
+		if (!shader)
+			shader.reset(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, defines(mask) + constantDefines));
+		return *shader;
+	}
+
+	// "#define SYMBOL" lines for the features in `mask`
+	std::string defines(unsigned int mask) const
+	{
+		std::string result;
+		for (size_t i = 0; i < features.size(); i++)
+			if (mask & (1u << i))
+				result += "#define " + features[i] + "\n";
+		return result;
+	}
+
+	size_t variantCount() const
+	{
+		return variants.size();
+	}
+
+private:
+	std::string vertexPath, fragmentPath;
+	std::vector<std::string> features;
+	typedef std::pair<unsigned int, std::string> Key; // feature mask, specialization defines
+	std::map<Key, std::unique_ptr<Shader> > variants;
+};
+#endif
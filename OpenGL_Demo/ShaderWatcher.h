@@ -0,0 +1,220 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <glad/glad.h>
+
+#include "CpuProfiler.h"
+#include "Shader.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Shader hot reload. Watches the shader directories with inotify and, when a .vs, .fs or .gs file
+// is written, rebuilds every registered program built from it. Includes are not tracked per
+// program, so a changed .glsl include rebuilds every registered program. A rebuild is submitted
+// like any other Shader, so it compiles in the background where the driver supports parallel
+// compilation (and loads from the program cache when the file is reverted). update() swaps finished
+// rebuilds in at the frame boundary it is called from; a rebuild that fails to compile or link is
+// discarded with its log, and the old program stays in use.
+// inotify is Linux only; elsewhere the watcher reports itself inactive and update() does nothing.
+class ShaderWatcher
+{
+public:
+	explicit ShaderWatcher(const std::vector<std::string> &directories) : fd(-1)
+	{
+#ifdef __linux__
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd < 0)
+		{
+			std::cout << "ERROR::SHADER_WATCHER::INOTIFY_INIT_FAILED" << std::endl;
+			return;
+		}
+		for (size_t i = 0; i < directories.size(); i++)
+		{
+			// editors either rewrite the file in place or rename a temporary over it
+			int wd = inotify_add_watch(fd, directories[i].c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+			if (wd < 0)
+				std::cout << "ERROR::SHADER_WATCHER::CANNOT_WATCH " << directories[i] << std::endl;
+			else
+				watches.push_back(Watch{ wd, normalize(directories[i]) });
+		}
+#else
+		(void)directories;
+#endif
+	}
+
+	~ShaderWatcher()
+	{
+		for (size_t i = 0; i < pending.size(); i++)
+			discard(pending[i]);
+#ifdef __linux__
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+
+	bool active() const
+	{
+		return fd >= 0 && !watches.empty();
+	}
+
+	void add(Shader *shader)
+	{
+		shaders.push_back(shader);
+	}
+
+	// call between frames: schedules rebuilds for changed files and swaps in those that are done.
+	// Returns the number of programs replaced; their uniforms are back at defaults and need setting again.
+	int update()
+	{
+		if (!active())
+			return 0;
+		PROFILE_ZONE("ShaderWatcher::update");
+		std::vector<std::string> changed;
+		poll(changed);
+		for (size_t i = 0; i < shaders.size(); i++)
+			if (usesAny(*shaders[i], changed))
+				schedule(shaders[i]);
+
+		int swapped = 0;
+		for (size_t i = 0; i < pending.size();)
+		{
+			Pending &p = pending[i];
+			if (!p.rebuild->ready())
+			{
+				i++;
+				continue;
+			}
+			if (p.rebuild->linked())
+			{
+				p.target->swapProgram(*p.rebuild);
+				swapped++;
+				std::cout << "Shader reload: " << describe(*p.target) << std::endl;
+			}
+			else
+				std::cout << "ERROR::SHADER_WATCHER::RELOAD_FAILED " << describe(*p.target) << ", keeping the previous program" << std::endl;
+			discard(p);
+			pending.erase(pending.begin() + i);
+		}
+		return swapped;
+	}
+
+private:
+	struct Watch {
+		int wd;
+		std::string directory;
+	};
+	struct Pending {
+		Shader *target;
+		std::shared_ptr<Shader> rebuild;
+	};
+
+	int fd;
+	std::vector<Watch> watches;
+	std::vector<Shader*> shaders;
+	std::vector<Pending> pending;
+
+	// drains the inotify queue without blocking; `changed` receives normalized paths of shader sources
+	void poll(std::vector<std::string> &changed)
+	{
+#ifdef __linux__
+		alignas(inotify_event) char buffer[4096];
+		while (true)
+		{
+			ssize_t length = read(fd, buffer, sizeof(buffer));
+			if (length <= 0)
+				break; // EAGAIN: nothing more queued
+			for (ssize_t offset = 0; offset < length;)
+			{
+				const inotify_event *event = (const inotify_event*)(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				if (event->len == 0 || !isShaderSource(event->name))
+					continue;
+				for (size_t i = 0; i < watches.size(); i++)
+					if (watches[i].wd == event->wd)
+						changed.push_back(watches[i].directory + "/" + event->name);
+			}
+		}
+#else
+		(void)changed;
+#endif
+	}
+
+	// a newer edit supersedes a rebuild still in flight
+	void schedule(Shader *target)
+	{
+		for (size_t i = 0; i < pending.size(); i++)
+			if (pending[i].target == target)
+			{
+				discard(pending[i]);
+				pending.erase(pending.begin() + i);
+				break;
+			}
+		const std::vector<std::string> &paths = target->sourcePaths();
+		Pending p;
+		p.target = target;
+		p.rebuild = std::make_shared<Shader>(paths[0].c_str(), paths[1].c_str(), paths.size() > 2 ? paths[2].c_str() : nullptr, target->sourceDefines());
+		pending.push_back(p);
+	}
+
+	// deletes the program a rebuild holds: the failed rebuild itself, or the old program after a swap
+	static void discard(Pending &p)
+	{
+		p.rebuild->finish(); // releases the shader objects of a program still compiling
+		glDeleteProgram(p.rebuild->ID);
+	}
+
+	static bool usesAny(const Shader &shader, const std::vector<std::string> &changed)
+	{
+		const std::vector<std::string> &paths = shader.sourcePaths();
+		for (size_t j = 0; j < changed.size(); j++)
+		{
+			if (hasExtension(changed[j], ".glsl"))
+				return true;
+			for (size_t i = 0; i < paths.size(); i++)
+				if (normalize(paths[i]) == changed[j])
+					return true;
+		}
+		return false;
+	}
+
+	static bool isShaderSource(const std::string &name)
+	{
+		return hasExtension(name, ".vs") || hasExtension(name, ".fs") || hasExtension(name, ".gs") || hasExtension(name, ".glsl");
+	}
+
+	static bool hasExtension(const std::string &name, const std::string &extension)
+	{
+		return name.size() >= extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+	}
+
+	// "./shaders/x.vs" and "shaders//x.vs" name the same file
+	static std::string normalize(const std::string &path)
+	{
+		std::string result;
+		for (size_t i = 0; i < path.size(); i++)
+			if (path[i] != '/' || result.empty() || result[result.size() - 1] != '/')
+				result += path[i] == '\\' ? '/' : path[i];
+		while (result.compare(0, 2, "./") == 0)
+			result.erase(0, 2);
+		if (result.size() > 1 && result[result.size() - 1] == '/')
+			result.erase(result.size() - 1);
+		return result;
+	}
+
+	static std::string describe(const Shader &shader)
+	{
+		const std::vector<std::string> &paths = shader.sourcePaths();
+		std::string result;
+		for (size_t i = 0; i < paths.size(); i++)
+			result += (i > 0 ? " + " : "") + paths[i];
+		return result;
+	}
+};
+#endif
@@ -7,11 +7,30 @@
 #include "Camera.h"
 #include "Model.h"
 #include <iostream>
+#include <memory>
+#include <cstdio>
 #include "Shader.h"
 #include "stb_image.h"
+#include "Options.h"
+#include "Benchmark.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "GoldenTest.h"
+#include "GLStats.h"
+#include "CameraPath.h"
+#include "MicroBench.h"
+#include "PerfHud.h"
+#include "MemoryRegistry.h"
+#include "FrameCapture.h"
+#include "FrameUniforms.h"
+#include "ProgramCache.h"
+#include "ShaderWatcher.h"
+#include "ShaderFamily.h"
+#include "PipelineState.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+unsigned int pollInput(GLFWwindow *window);
+void processInput(GLFWwindow *window, unsigned int keys);
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
@@ -19,13 +38,19 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 unsigned int loadTexture(const char *path);
 unsigned int loadCubemap(vector<std::string> faces);
 void renderQuad();
+void buildSphere();
 void renderSphere();
+void releaseSphere();
+Specialization staticMaterialConstants();
+int runMicroBenchmarks(const RunOptions &options);
+int runScene(GLFWwindow *window, const RunOptions &options);
 //void renderCube();
 // settings
 const unsigned int SCR_WIDTH = 1600;
 const unsigned int SCR_HEIGHT = 1600;
 bool set_hdr = true;
 bool hdrKeyPressed = false;
+bool memoryKeyPressed = false;
 float exposure = 1.2f;
 
 // camera
@@ -33,6 +58,9 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
+// recorded or replayed camera path
+CameraPath cameraPath;
+bool replaying = false;
 
 // timing
 float deltaTime = 0.0f;	// time between current frame and last frame
@@ -41,8 +69,22 @@ float lastFrame = 0.0f;
 // lighting
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-int main()
+// variant features of multi_light_material.fs, in the order given to its ShaderFamily
+enum MultiLightFeature {
+	MULTI_LIGHT_DIRECTIONAL = 1 << 0,
+	MULTI_LIGHT_POINT = 1 << 1,
+	MULTI_LIGHT_SPOT = 1 << 2,
+	MULTI_LIGHT_PHONG = 1 << 3 // Phong instead of Blinn-Phong specular
+};
+// material and light parameters that never change at run time, baked into the multi-light variants
+const float MATERIAL_SHININESS = 64.0f;
+const glm::vec3 POINT_LIGHT_FALLOFF(1.0f, 0.09f, 0.1f); // constant, linear, quadratic attenuation terms
+
+int main(int argc, char **argv)
 {
+	RunOptions options = parseOptions(argc, argv);
+	CpuProfiler::enabled() = !options.cpuTracePath.empty();
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -56,7 +98,21 @@ int main()
 
 	// glfw window creation
 	// --------------------
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+	GLFWwindow* window = NULL;
+	if (options.headless)
+	{
+		// offscreen context: try OSMesa first (GPU-less boxes under llvmpipe), then EGL
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+		if (window == NULL)
+		{
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+			window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+		}
+	}
+	else
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
 	if (window == NULL)
 	{
 		std::cout << "Failed to create GLFW window" << std::endl;
@@ -77,7 +133,61 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
+	// block sizes the shaders share with FrameUniforms
+	Shader::globalDefines() = frameUniformDefines();
+	// models imported by an earlier run load from their binary cache entry instead of Assimp
+	if (options.meshCache)
+		MeshCache::init(options.meshCacheDir);
+	MeshOptimizer::enabled() = options.meshOptimize;
+	MeshWelder::enabled() = options.meshWeld;
+	Mesh::splitIndices() = options.splitIndices;
+	if (!options.weldEpsilon.empty())
+	{
+		MeshWelder::Tolerance &tolerance = MeshWelder::tolerance();
+		if (std::sscanf(options.weldEpsilon.c_str(), "%f,%f,%f,%f", &tolerance.position, &tolerance.normal, &tolerance.texCoord, &tolerance.tangent) != 4)
+		{
+			std::cout << "ERROR::MESH::BAD_WELD_EPSILON " << options.weldEpsilon << " (position,normal,texcoord,tangent)" << std::endl;
+			return -1;
+		}
+	}
+	if (options.vertexFormat == "packed")
+		Mesh::defaultVertexFormat() = VERTEX_FORMAT_PACKED;
+	else if (options.vertexFormat != "float")
+	{
+		std::cout << "ERROR::MESH::UNKNOWN_VERTEX_FORMAT " << options.vertexFormat << " (float or packed)" << std::endl;
+		return -1;
+	}
+	// GL call interception: must be installed before any resource is created so uploads are counted
+	GLStats &glStats = GLStats::instance();
+	if (options.glStats || options.hud)
+	{
+		glStats.logInterval = options.glStats ? options.glStatsInterval : 0;
+		glStats.install();
+	}
+
+	if (options.microBench)
+	{
+		int result = runMicroBenchmarks(options);
+		glfwTerminate();
+		return result;
+	}
+
+
+	// the scene's GL objects are released when runScene returns, while the context still exists
+	int result = runScene(window, options);
+
+	// glfw: terminate, clearing all previously allocated GLFW resources.
+	// ------------------------------------------------------------------
+	glfwTerminate();
+	return result;
+}
 
+// loads the scene and runs the render loop until the window closes, the frame budget of a headless
+// run is spent or the golden poses are done; returns the exit code
+// ---------------------------------------------------------------------------------------------------------
+int runScene(GLFWwindow *window, const RunOptions &options)
+{
+	GLStats &glStats = GLStats::instance();
 
 	//Configure global opengl state
 	glEnable(GL_DEPTH_TEST);
@@ -88,6 +198,11 @@ int main()
 //	glCullFace(GL_BACK);
 //	glFrontFace(GL_CW);
 
+	// program binaries cached by an earlier run replace compiling and linking from source (warm start)
+	if (options.shaderCache)
+		ProgramCache::init((GLADloadproc)glfwGetProcAddress, options.shaderCacheDir);
+	Shader::enableParallelCompile((GLADloadproc)glfwGetProcAddress);
+	double shaderStart = glfwGetTime();
 	//Shader myShader1("./shaders/vertexshader/test2.vs", "./shaders/fragmentshader/test2.fs");
 	//Shader myShader2("./shaders/vertexshader/test3.vs", "./shaders/fragmentshader/test3.fs");
 	Shader myShader3("./shaders/vertexshader/test4.vs", "./shaders/fragmentshader/test2.fs");
@@ -96,12 +211,18 @@ int main()
 	Shader phongShader("./shaders/vertexshader/lighted_norm.vs", "./shaders/fragmentshader/phong.fs");
 	Shader phongMatShader("./shaders/vertexshader/lighted_norm.vs", "./shaders/fragmentshader/phong_material.fs");
 	Shader texmaterialshader("./shaders/vertexshader/texture_material.vs", "./shaders/fragmentshader/texture_material.fs");
-	Shader multiLightMat("./shaders/vertexshader/multi_light_material.vs", "./shaders/fragmentshader/multi_light_material.fs");
-	Shader multiLightMat2("./shaders/vertexshader/multi_light_material.vs", "./shaders/fragmentshader/multi_light_material.fs");
+	ShaderFamily multiLight("./shaders/vertexshader/multi_light_material.vs", "./shaders/fragmentshader/multi_light_material.fs",
+		{ "DIRECTIONAL_LIGHT", "POINT_LIGHTS", "SPOT_LIGHT", "PHONG_SPECULAR" });
+	// the textured cube and the globe are both lit by the sun and the two point lights
+	Shader &multiLightMat = multiLight.variant(MULTI_LIGHT_DIRECTIONAL | MULTI_LIGHT_POINT, staticMaterialConstants());
 	Shader skyboxShader("./shaders/vertexshader/skybox.vs", "./shaders/fragmentshader/skybox.fs");
 	Shader reflectionShader("./shaders/vertexshader/reflection.vs", "./shaders/fragmentshader/reflection.fs");
 	Shader hdr("./shaders/vertexshader/hdr.vs", "./shaders/fragmentshader/hdr.fs");
 	Shader pbr("./shaders/vertexshader/CT_brdf.vs", "./shaders/fragmentshader/CT_brdf.fs");
+	// the programs keep compiling while textures and models load; the render loop collects them
+	std::vector<Shader*> scenePrograms = { &myShader3, &basiclightsource, &lightedShader, &phongShader, &phongMatShader, &texmaterialshader,
+		&multiLightMat, &skyboxShader, &reflectionShader, &hdr, &pbr };
+	bool programsReady = false;
 
 	// set up vertex data (and buffer(s)) and configure vertex attributes
 	// ------------------------------------------------------------------
@@ -237,6 +358,7 @@ int main()
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO4);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices4), vertices4, GL_STATIC_DRAW);
+	MemoryRegistry::instance().addBuffer(VBO4, "colored_cube", MemoryRegistry::VERTEX_BUFFER, sizeof(vertices4));
 
 	// position attribute
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
@@ -253,6 +375,7 @@ int main()
 	// we only need to bind to the VBO, the container's VBO's data already contains the correct data.
 	glBindBuffer(GL_ARRAY_BUFFER, VBO5);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices5), vertices5, GL_STATIC_DRAW);
+	MemoryRegistry::instance().addBuffer(VBO5, "light_cube", MemoryRegistry::VERTEX_BUFFER, sizeof(vertices5));
 	// position attribute
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
@@ -313,6 +436,7 @@ int main()
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO6);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices6), vertices6, GL_STATIC_DRAW);
+	MemoryRegistry::instance().addBuffer(VBO6, "textured_cube", MemoryRegistry::VERTEX_BUFFER, sizeof(vertices6));
 
 	glBindVertexArray(texcubeVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
@@ -392,6 +516,7 @@ int main()
 	glBindVertexArray(skyboxVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+	MemoryRegistry::instance().addBuffer(skyboxVBO, "skybox", MemoryRegistry::VERTEX_BUFFER, sizeof(skyboxVertices));
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
@@ -421,6 +546,8 @@ int main()
 	glGenRenderbuffers(1, &rboDepth);
 	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
+	MemoryRegistry::instance().addTexture(colorBuffer, "hdr_color", GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 1, 1, MemoryRegistry::RENDER_TARGET);
+	MemoryRegistry::instance().addRenderbuffer(rboDepth, "hdr_depth", GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
 	// attach buffers
 	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorBuffer, 0);
@@ -433,31 +560,29 @@ int main()
 
 
 
-	// shader configuration
+	// shader configuration, run once the programs have finished compiling
 	// --------------------
-	multiLightMat.use();
-	multiLightMat.setInt("material.diffuse", 0);
-	multiLightMat.setInt("material.specular", 1);
-
-	multiLightMat2.use();
-	multiLightMat2.setInt("material.diffuse", 0);
-	multiLightMat2.setInt("material.specular", 1);
+	std::function<void()> configurePrograms = [&] {
+		multiLightMat.use();
+		multiLightMat.setInt("material.diffuse", 0);
+		multiLightMat.setInt("material.specular", 1);
 
-	skyboxShader.use();
-	skyboxShader.setInt("skybox", 0);
+		skyboxShader.use();
+		skyboxShader.setInt("skybox", 0);
 
-	reflectionShader.use();
-	reflectionShader.setInt("skybox", 0);
+		reflectionShader.use();
+		reflectionShader.setInt("skybox", 0);
 
-	hdr.use();
-	hdr.setInt("hdrBuffer", 0);
+		hdr.use();
+		hdr.setInt("hdrBuffer", 0);
 
-	pbr.use();
-	pbr.setInt("albedoMap", 0);
-	pbr.setInt("normalMap", 1);
-	pbr.setInt("metallicMap", 2);
-	pbr.setInt("roughnessMap", 3);
-	pbr.setInt("aoMap", 4);
+		pbr.use();
+		pbr.setInt("albedoMap", 0);
+		pbr.setInt("normalMap", 1);
+		pbr.setInt("metallicMap", 2);
+		pbr.setInt("roughnessMap", 3);
+		pbr.setInt("aoMap", 4);
+	};
 
 	//1st material pbr
 /*	unsigned int albedo = loadTexture("./texture/pbr_metal/streaked-metal1-albedo.png");
@@ -488,7 +613,23 @@ int main()
 	//Going to 3D
 
 	//Load Sphere model
+	double modelStart = glfwGetTime();
 	Model sphere1("./Model/globe-sphere.obj");
+	std::cout << "Model load: globe-sphere " << (glfwGetTime() - modelStart) * 1000.0 << " ms, "
+		<< (!MeshCache::enabled() ? "mesh cache off" : MeshCache::stats().hits > 0 ? "mapped from the mesh cache" : "imported") << std::endl;
+
+	//Pipeline state of every pass; applying one issues only what differs from the pass before
+	RasterState skyboxRaster;
+	skyboxRaster.depthFunc = GL_LEQUAL; // the skybox sits at depth 1.0, which must pass where nothing was drawn
+	PipelineState colorGlobePass(myShader3);
+	PipelineState litGlobePass(multiLightMat, 0, RasterState(), { { 0, GL_TEXTURE_2D, diffuseMap2 }, { 1, GL_TEXTURE_2D, specularMap2 } });
+	PipelineState reflectionPass(reflectionShader, 0, RasterState(), { { 0, GL_TEXTURE_CUBE_MAP, skyTexture } });
+	PipelineState pbrPass(pbr, 0, RasterState(), { { 0, GL_TEXTURE_2D, albedo }, { 1, GL_TEXTURE_2D, normal }, { 2, GL_TEXTURE_2D, metallic },
+		{ 3, GL_TEXTURE_2D, roughness }, { 4, GL_TEXTURE_2D, ao } });
+	PipelineState cubePass(multiLightMat, texcubeVAO, RasterState(), { { 0, GL_TEXTURE_2D, diffuseMap }, { 1, GL_TEXTURE_2D, specularMap } });
+	PipelineState lampPass(basiclightsource, lightVAO);
+	PipelineState skyboxPass(skyboxShader, skyboxVAO, skyboxRaster, { { 0, GL_TEXTURE_CUBE_MAP, skyTexture } });
+	PipelineState tonemapPass(hdr, 0, RasterState(), { { 0, GL_TEXTURE_2D, colorBuffer } });
 	
 	
 
@@ -499,21 +640,130 @@ int main()
 	//Before render
 	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), float(SCR_WIDTH / SCR_HEIGHT), 0.1f, 100.0f);
 
+	//Headless benchmark
+	FrameStats frameStats;
+	int frameIndex = 0;
+	int totalFrames = options.warmup + options.frames;
+
+	//Camera path record / replay (golden runs use their own fixed poses)
+	if (!options.replayPath.empty() && !options.golden)
+	{
+		replaying = cameraPath.load(options.replayPath);
+		if (!replaying)
+			return -1;
+		totalFrames = (int)cameraPath.frames.size();
+	}
+	else if (!options.recordPath.empty())
+	{
+		cameraPath.fixedDeltaTime = options.replayDeltaTime;
+		cameraPath.startRecording(options.recordPath);
+	}
+
+	//Golden image regression
+	GoldenTest goldenTest(options.goldenDir, options.updateGolden, options.goldenTolerance);
+	if (options.golden)
+		totalFrames = goldenTest.totalFrames();
+
+	//Shared camera and light uniform blocks
+	FrameUniforms frameUniforms;
+
+	//Per-pass GPU timings
+	GpuProfiler gpuProfiler(options.gpuProfile || options.hud, options.gpuProfile ? options.gpuProfileInterval : 0);
+
+	//Performance overlay (kept out of golden images)
+	std::unique_ptr<PerfHud> hud;
+	if (options.hud && !options.golden)
+		hud.reset(new PerfHud());
+
+	//Asynchronous frame capture (golden runs read back their own images)
+	std::unique_ptr<FrameCapture> frameCapture;
+	if (!options.captureDir.empty() && !options.golden)
+	{
+		FrameCapture::Format captureFormat;
+		if (!FrameCapture::parseFormat(options.captureFormat, captureFormat))
+		{
+			std::cout << "ERROR::FRAME_CAPTURE::UNKNOWN_FORMAT " << options.captureFormat << " (png, y4m or raw)" << std::endl;
+			return -1;
+		}
+		// video runs at the simulated clock: the replayed path's time step, else the one given for recording
+		float frameDeltaTime = replaying ? cameraPath.fixedDeltaTime : options.replayDeltaTime;
+		frameCapture.reset(new FrameCapture(options.captureDir, captureFormat, SCR_WIDTH, SCR_HEIGHT, (int)(1.0f / frameDeltaTime + 0.5f)));
+	}
+
+	//Shader hot reload (windowed runs; offline runs stay reproducible)
+	std::unique_ptr<ShaderWatcher> shaderWatcher;
+	if (options.shaderHotReload && !options.headless)
+	{
+		shaderWatcher.reset(new ShaderWatcher({ "./shaders/vertexshader", "./shaders/fragmentshader", "./shaders/include" }));
+		for (size_t i = 0; i < scenePrograms.size(); i++)
+			shaderWatcher->add(scenePrograms[i]);
+	}
 
 	// render loop
 	// -----------
-	while (!glfwWindowShouldClose(window))
+	while (!glfwWindowShouldClose(window) && !((options.headless || replaying) && frameIndex >= totalFrames))
 	{
+		PROFILE_ZONE("frame");
+
+		// until every scene program has compiled, a windowed run only clears the screen; offline runs wait
+		if (!programsReady)
+		{
+			programsReady = true;
+			if (!options.headless)
+				for (size_t i = 0; i < scenePrograms.size(); i++)
+					programsReady = programsReady && scenePrograms[i]->ready();
+			if (!programsReady)
+			{
+				glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glfwSwapBuffers(window);
+				glfwPollEvents();
+				continue;
+			}
+			// finishing stores each binary in the program cache, including programs the scene never uses
+			for (size_t i = 0; i < scenePrograms.size(); i++)
+				scenePrograms[i]->finish();
+			configurePrograms();
+			const ProgramCache::Stats &cache = ProgramCache::stats();
+			std::cout << "Shader startup: " << scenePrograms.size() << " programs ready " << (glfwGetTime() - shaderStart) * 1000.0 << " ms after submission"
+				<< (Shader::parallelCompile() ? " (parallel compile)" : "") << ", ";
+			if (!ProgramCache::enabled())
+				std::cout << "program cache off" << std::endl;
+			else
+				std::cout << (cache.misses == 0 ? "warm" : "cold") << " start (" << cache.hits << " cached, " << cache.misses << " compiled, "
+					<< cache.rejected << " rejected, " << cache.stored << " stored)" << std::endl;
+		}
+		// edited shaders are swapped in here, between frames; a new program needs its sampler units again
+		if (shaderWatcher && shaderWatcher->update() > 0)
+			configurePrograms();
+
 		// per-frame time logic
 		// --------------------
+		double frameStart = glfwGetTime();
+		if (options.golden)
+			goldenTest.beginFrame(frameIndex, camera);
 		float currentFrame = glfwGetTime();
+		if (options.golden)
+			currentFrame = goldenTest.sceneTime;
+		else if (replaying)
+			currentFrame = cameraPath.sceneTime(frameIndex);
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 
 		// input
 		// -----
-		processInput(window);
+		unsigned int keys = replaying ? cameraPath.frames[frameIndex].keys : pollInput(window);
+		processInput(window, keys);
+		if (replaying)
+			cameraPath.apply(frameIndex, camera);
+		cameraPath.recordFrame(currentFrame, deltaTime, camera, (uint16_t)keys);
+		gpuProfiler.beginFrame();
+		glStats.beginFrame();
+		if (hud)
+			hud->beginFrame();
+		// loading, shader reloads and the previous frame's overlay change state behind the pipelines' back
+		PipelineState::invalidate();
 
 		// render
 		// ------
@@ -522,6 +772,7 @@ int main()
 
 		//HDR begin
 		glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+		gpuProfiler.begin("scene");
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		
 
@@ -534,133 +785,97 @@ int main()
 
 
 		// update the uniform color
-		float timeValue = glfwGetTime();
+		float timeValue = currentFrame;
 		float greenValue = sin(timeValue) / 2.0f + 0.5f;
 		float redValue = sin(timeValue+1.57) / 2.0f + 0.5f;
 		float blueValue = sin(timeValue+3.14) / 2.0f + 0.5f;
 		//float alphaValue = sin(timeValue + 5) / 2.0f + 0.5f;
 		//std::cout << greenValue << std::endl;
 
-		//Lights 1
-		multiLightMat.use();
-		multiLightMat.setVec3("viewPos", camera.Position);
-		multiLightMat.setFloat("material.shininess", 64.0f);
-
 		glm::vec3 lightColor(glm::vec3(redValue, greenValue, blueValue));
 		glm::vec3 diffuseColor = lightColor * glm::vec3(2.0f);   // decrease the influence
 		glm::vec3 ambientColor = diffuseColor * glm::vec3(0.4f); // low influence
 
 		glm::vec3 lightPosition1(cos(timeValue) * 3, 1.5f, sin(timeValue) * 2);
 		glm::vec3 lightPosition2(cos(timeValue+3.14) * 3, 1.5f, sin(timeValue+3.14) * 2);
-		//Directional light
-		multiLightMat.setVec3("dirLight.direction", 0.2f, 1.0f, -0.3f);
-		multiLightMat.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-		multiLightMat.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-		multiLightMat.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-
-		// point light 1
-		multiLightMat.setVec3("pointLights[0].position", lightPosition1);
-		multiLightMat.setVec3("pointLights[0].ambient", ambientColor);
-		multiLightMat.setVec3("pointLights[0].diffuse", diffuseColor*2.0f);
-		multiLightMat.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-		multiLightMat.setFloat("pointLights[0].constant", 1.0f);
-		multiLightMat.setFloat("pointLights[0].linear", 0.09);
-		multiLightMat.setFloat("pointLights[0].quadratic", 0.1);
-		// point light 2
-		multiLightMat.setVec3("pointLights[1].position", lightPosition2);
-		multiLightMat.setVec3("pointLights[1].ambient", ambientColor);
-		multiLightMat.setVec3("pointLights[1].diffuse", diffuseColor*2.0f);
-		multiLightMat.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-		multiLightMat.setFloat("pointLights[1].constant", 1.0f);
-		multiLightMat.setFloat("pointLights[1].linear", 0.09);
-		multiLightMat.setFloat("pointLights[1].quadratic", 0.1);
-
-		//Light2
-
-		multiLightMat2.use();
-		multiLightMat2.setVec3("viewPos", camera.Position);
-		multiLightMat2.setFloat("material.shininess", 64.0f);
-
-
-		//Directional light
-		multiLightMat2.setVec3("dirLight.direction", 0.2f, 1.0f, -0.3f);
-		multiLightMat2.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-		multiLightMat2.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-		multiLightMat2.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-
-		// point light 1
-		multiLightMat2.setVec3("pointLights[0].position", lightPosition1);
-		multiLightMat2.setVec3("pointLights[0].ambient", ambientColor);
-		multiLightMat2.setVec3("pointLights[0].diffuse", diffuseColor*2.0f);
-		multiLightMat2.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-		multiLightMat2.setFloat("pointLights[0].constant", 1.0f);
-		multiLightMat2.setFloat("pointLights[0].linear", 0.09);
-		multiLightMat2.setFloat("pointLights[0].quadratic", 0.1);
-		// point light 2
-		multiLightMat2.setVec3("pointLights[1].position", lightPosition2);
-		multiLightMat2.setVec3("pointLights[1].ambient", ambientColor);
-		multiLightMat2.setVec3("pointLights[1].diffuse", diffuseColor*2.0f);
-		multiLightMat2.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-		multiLightMat2.setFloat("pointLights[1].constant", 1.0f);
-		multiLightMat2.setFloat("pointLights[1].linear", 0.09);
-		multiLightMat2.setFloat("pointLights[1].quadratic", 0.1);
+
+		//Per-frame uniform blocks: camera and lights go up in one buffer upload each
+		{
+			PROFILE_ZONE("frame_uniforms");
+			projection = glm::perspective(glm::radians(camera.Zoom), float(SCR_WIDTH / SCR_HEIGHT), 0.1f, 100.0f);
+			frameUniforms.setCamera(projection, view, camera.Position);
+
+			//Directional light
+			DirLightStd140 &dirLight = frameUniforms.lights.dirLight;
+			dirLight.direction = glm::vec3(0.2f, 1.0f, -0.3f);
+			dirLight.ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+			dirLight.diffuse = glm::vec3(0.4f, 0.4f, 0.4f);
+			dirLight.specular = glm::vec3(0.5f, 0.5f, 0.5f);
+
+			// point lights
+			glm::vec3 pointLightPosition[NR_POINT_LIGHTS] = { lightPosition1, lightPosition2 };
+			for (int i = 0; i < NR_POINT_LIGHTS; i++)
+			{
+				PointLightStd140 &light = frameUniforms.lights.pointLights[i];
+				light.position = pointLightPosition[i];
+				light.ambient = ambientColor;
+				light.diffuse = diffuseColor*2.0f;
+				light.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+				light.constant = POINT_LIGHT_FALLOFF.x;
+				light.linear = POINT_LIGHT_FALLOFF.y;
+				light.quadratic = POINT_LIGHT_FALLOFF.z;
+				light.color = lightColor;
+			}
+			frameUniforms.upload();
+		}
 
 
 
 		//4th colored shape box
-		myShader3.use();
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(2.0f,0.0f,0));
-		view = camera.GetViewMatrix();
-		projection = glm::mat4(1.0f);
-		projection = glm::perspective(glm::radians(camera.Zoom), float(SCR_WIDTH / SCR_HEIGHT), 0.1f, 100.0f);
-		glm::mat4 mvp;
-		model = glm::rotate(model,  (float)glfwGetTime(), glm::vec3(1.0f, 0.3f, 0.5f));
-		//model = glm::scale(model, glm::vec3(0.5f));
-		mvp = projection * view*model;
-		myShader3.setVec4("ourColor2",glm::vec4(redValue, greenValue, blueValue, 1.0f));
-		myShader3.setMat4("mvp", mvp);
-		/*glBindVertexArray(VAO4);
-		glDrawArrays(GL_TRIANGLES, 0, 36);*/
-		sphere1.Draw(myShader3);
+		{
+			PROFILE_ZONE("globe");
+			gpuProfiler.begin("globe");
+			colorGlobePass.apply();
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, glm::vec3(2.0f,0.0f,0));
+			glm::mat4 mvp;
+			model = glm::rotate(model,  currentFrame, glm::vec3(1.0f, 0.3f, 0.5f));
+			//model = glm::scale(model, glm::vec3(0.5f));
+			mvp = projection * view*model;
+			myShader3.setVec4("ourColor2",glm::vec4(redValue, greenValue, blueValue, 1.0f));
+			myShader3.setMat4("mvp", mvp);
+			/*glBindVertexArray(VAO4);
+			glDrawArrays(GL_TRIANGLES, 0, 36);*/
+			sphere1.Draw(myShader3);
 	
-		//5th lighted box
+			//5th lighted box
 	
-		/*
+			/*
 
-		multiLightMat.use();
-		model = glm::mat4(1.0f);
-		multiLightMat.setMat4("projection", projection);
-		multiLightMat.setMat4("view", view);
-		multiLightMat.setMat4("model", model);
-		//lightedShader.setMat4("mvp", projection*view*model);
-		glBindVertexArray(lightVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);*/
-
-		//Sphere1 
-		multiLightMat2.use();
-		model = glm::mat4(1.0f);
-		multiLightMat2.setMat4("projection", projection);
-		multiLightMat2.setMat4("view", view);
-		multiLightMat2.setMat4("model", model);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap2);
-		// bind specular map
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, specularMap2);
-		
-		sphere1.Draw(multiLightMat2);
+			multiLightMat.use();
+			model = glm::mat4(1.0f);
+			multiLightMat.setMat4("projection", projection);
+			multiLightMat.setMat4("view", view);
+			multiLightMat.setMat4("model", model);
+			//lightedShader.setMat4("mvp", projection*view*model);
+			glBindVertexArray(lightVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 36);*/
+
+			//Sphere1 
+			litGlobePass.apply();
+			model = glm::mat4(1.0f);
+			multiLightMat.setMat4("model", model);
+			sphere1.Draw(multiLightMat);
 
-		//Sphere2
-		reflectionShader.use();
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(0.0f, 0.0f, -2.0f));
-		reflectionShader.setMat4("projection", projection);
-		reflectionShader.setMat4("view", view);
-		reflectionShader.setMat4("model", model);
-		reflectionShader.setVec3("cameraPos", camera.Position);
+			//Sphere2
+			reflectionPass.apply();
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, glm::vec3(0.0f, 0.0f, -2.0f));
+			reflectionShader.setMat4("model", model);
 
-		sphere1.Draw(reflectionShader);
+			sphere1.Draw(reflectionShader);
+			gpuProfiler.end();
+		}
 
 
 	/*	multiLightMat.use();
@@ -672,39 +887,22 @@ int main()
 		*/
 
 		//PBR sphere
-		pbr.use();
-		view = camera.GetViewMatrix();
-		pbr.setMat4("view", view);
-		pbr.setMat4("projection", projection);
-		pbr.setVec3("camPos", camera.Position);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, albedo);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, normal);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, metallic);
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, roughness);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, ao);
-
-		//	pbr.setFloat("metallic", 0.8f);
-		
+		{
+			PROFILE_ZONE("pbr_sphere");
+			gpuProfiler.begin("pbr_sphere");
+			pbrPass.apply();
 
-		//	pbr.setFloat("roughness", 0.2f);
-			model = glm::mat4(1.0f);
-			model = glm::translate(model, glm::vec3(0.0f,0.0f,2.0f));
-			pbr.setMat4("model", model);
-			
-			//pbr.setInt("nb_light", 2);
-			pbr.setVec3("lightPositions[0]", lightPosition1);
-			pbr.setVec3("lightColors[0]", lightColor);
+			//	pbr.setFloat("metallic", 0.8f);
+		
 
-			pbr.setVec3("lightPositions[1]", lightPosition2);
-			pbr.setVec3("lightColors[1]", lightColor);
+			//	pbr.setFloat("roughness", 0.2f);
+				model = glm::mat4(1.0f);
+				model = glm::translate(model, glm::vec3(0.0f,0.0f,2.0f));
+				pbr.setMat4("model", model);
 
-			renderSphere();
+				renderSphere();
+				gpuProfiler.end();
+		}
 
 		//	sphere1.Draw(pbr);
 			
@@ -713,60 +911,50 @@ int main()
 
 
 
-		multiLightMat.use();
-		multiLightMat.setMat4("projection", projection);
-		multiLightMat.setMat4("view", view);
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(-2.0f, 0.0f, 0));
-		multiLightMat.setMat4("model", model);
-
-		// bind diffuse map
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
-		// bind specular map
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, specularMap);
-
-		glBindVertexArray(texcubeVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		//Cube
+		{
+			PROFILE_ZONE("cube");
+			gpuProfiler.begin("cube");
+			cubePass.apply();
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, glm::vec3(-2.0f, 0.0f, 0));
+			multiLightMat.setMat4("model", model);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+			gpuProfiler.end();
+		}
 
 
 
 		//6th lamp
-		basiclightsource.use();
-		basiclightsource.setVec4("ourColor", glm::vec4(lightColor, 1.0f));
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, lightPosition1);
-		model = glm::scale(model, glm::vec3(0.2f));
-		basiclightsource.setMat4("projection", projection);
-		basiclightsource.setMat4("view", view);
-		basiclightsource.setMat4("model", model);
-		glBindVertexArray(lightVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		{
+			PROFILE_ZONE("lights");
+			gpuProfiler.begin("lights");
+			lampPass.apply();
+			basiclightsource.setVec4("ourColor", glm::vec4(lightColor, 1.0f));
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, lightPosition1);
+			model = glm::scale(model, glm::vec3(0.2f));
+			basiclightsource.setMat4("model", model);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
 
-		//7th lamp
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, lightPosition2);
-		model = glm::scale(model, glm::vec3(0.2f));
-		basiclightsource.setMat4("projection", projection);
-		basiclightsource.setMat4("view", view);
-		basiclightsource.setMat4("model", model);
-		glBindVertexArray(lightVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+			//7th lamp
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, lightPosition2);
+			model = glm::scale(model, glm::vec3(0.2f));
+			basiclightsource.setMat4("model", model);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+			gpuProfiler.end();
+		}
 
 		// draw skybox as last
-		glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-		skyboxShader.use();
-		view = glm::mat4(glm::mat3(camera.GetViewMatrix())); // remove translation from the view matrix
-		skyboxShader.setMat4("view", view);
-		skyboxShader.setMat4("projection", projection);
-		// skybox cube
-		glBindVertexArray(skyboxVAO);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skyTexture);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-		glDepthFunc(GL_LESS); // set depth function back to default
+		{
+			PROFILE_ZONE("skybox");
+			gpuProfiler.begin("skybox");
+			skyboxPass.apply(); // skybox.vs removes the translation from the shared view matrix
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+			gpuProfiler.end();
+		}
+		gpuProfiler.end(); // scene
 
 
 
@@ -774,13 +962,22 @@ int main()
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		// 2. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
 		// --------------------------------------------------------------------------------------------------------------------------
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		hdr.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, colorBuffer);
-		hdr.setInt("hdr", set_hdr);
-		hdr.setFloat("exposure", exposure);
-		renderQuad();
+		{
+			PROFILE_ZONE("tonemap");
+			gpuProfiler.begin("tonemap");
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			tonemapPass.apply();
+			hdr.setInt("hdr", set_hdr);
+			hdr.setFloat("exposure", exposure);
+			renderQuad();
+			gpuProfiler.end();
+		}
+		if (hud)
+		{
+			PROFILE_ZONE("hud");
+			hud->render(SCR_WIDTH, SCR_HEIGHT, gpuProfiler, glStats);
+		}
+		gpuProfiler.endFrame();
 
 		
 
@@ -790,50 +987,119 @@ int main()
 		
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
+		if (options.golden && goldenTest.isCaptureFrame(frameIndex))
+			goldenTest.capture(frameIndex, hdrFBO, SCR_WIDTH, SCR_HEIGHT);
+		if (frameCapture)
+			frameCapture->capture();
+
+		glStats.endFrame();
+		Shader::uploadStats().endFrame();
+		PipelineState::stats().endFrame();
 		glfwSwapBuffers(window);
 		glfwPollEvents();
+
+		if (options.headless)
+		{
+			// wait for the GPU so the sample covers the whole frame, not just command submission
+			glFinish();
+			double frameMs = (glfwGetTime() - frameStart) * 1000.0;
+			if (options.golden)
+			{
+				if (goldenTest.isTimedFrame(frameIndex))
+					goldenTest.addTiming(frameMs);
+			}
+			else if (frameIndex >= options.warmup)
+				frameStats.addSample(frameMs);
+		}
+		frameIndex++;
 	}
 
+	if (options.golden)
+		goldenTest.report();
+	else if (options.headless)
+	{
+		std::string renderer = (const char*)glGetString(GL_RENDERER);
+		std::cout << "Renderer: " << renderer << std::endl;
+		frameStats.print(std::cout, "Frame time");
+		frameStats.writeJson(options.jsonPath, renderer);
+		gpuProfiler.log(std::cout);
+		glStats.log(std::cout);
+		std::cout << "Uniform uploads (last frame): " << Shader::uploadStats().lastIssued << " issued, " << Shader::uploadStats().lastSkipped << " skipped as unchanged" << std::endl;
+		const PipelineState::Stats &pipelineStats = PipelineState::stats();
+		std::cout << "Pipeline state (last frame): " << pipelineStats.lastApplies << " applies, " << pipelineStats.lastIssued << " state calls issued, "
+			<< pipelineStats.lastSkipped << " skipped as current" << std::endl;
+		MemoryRegistry::instance().log(std::cout);
+	}
+
+	cameraPath.stopRecording();
+	if (frameCapture)
+		frameCapture->finish();
+	if (!options.cpuTracePath.empty())
+		CpuProfiler::writeChromeTrace(options.cpuTracePath);
+
 	// optional: de-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
 	glDeleteVertexArrays(2, VAO);
 	glDeleteBuffers(2, VBO);
 //	glDeleteBuffers(1, &EBO);
 
-	// glfw: terminate, clearing all previously allocated GLFW resources.
-	// ------------------------------------------------------------------
-	glfwTerminate();
-	return 0;
+	return goldenTest.failures > 0 ? 1 : 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// query GLFW which of the keys processInput reacts to are pressed this frame
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window)
+unsigned int pollInput(GLFWwindow *window)
 {
+	unsigned int keys = 0;
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		keys |= INPUT_KEY_ESCAPE;
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+		keys |= INPUT_KEY_W;
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+		keys |= INPUT_KEY_S;
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+		keys |= INPUT_KEY_A;
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+		keys |= INPUT_KEY_D;
+	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+		keys |= INPUT_KEY_SPACE;
+	if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS)
+		keys |= INPUT_KEY_M;
+	return keys;
+}
+
+// process all input: react to the keys pressed this frame (polled live or replayed from a camera path)
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window, unsigned int keys)
+{
+	if (keys & INPUT_KEY_ESCAPE)
 		glfwSetWindowShouldClose(window, true);
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+	if (keys & INPUT_KEY_W)
 		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+	if (keys & INPUT_KEY_S)
 		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	if (keys & INPUT_KEY_A)
 		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+	if (keys & INPUT_KEY_D)
 		camera.ProcessKeyboard(RIGHT, deltaTime);
 
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !hdrKeyPressed)
+	if ((keys & INPUT_KEY_SPACE) && !hdrKeyPressed)
 	{
 		set_hdr = !set_hdr;
 		hdrKeyPressed = true;
 		std::cout << "hdr: " << (set_hdr ? "on" : "off") << "| exposure: " << exposure << std::endl;
 	}
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE)
+	if (!(keys & INPUT_KEY_SPACE))
 	{
 		hdrKeyPressed = false;
 		//std::cout << "hdr: " << (set_hdr ? "on" : "off") << "| exposure: " << exposure << std::endl;
 	}
 
+	if ((keys & INPUT_KEY_M) && !memoryKeyPressed)
+		MemoryRegistry::instance().log(std::cout);
+	memoryKeyPressed = (keys & INPUT_KEY_M) != 0;
+
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -877,6 +1143,9 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 // -------------------------------------------------------
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
+	// a replay drives the camera from the recorded path only
+	if (replaying)
+		return;
 	if (firstMouse)
 	{
 		lastX = xpos;
@@ -891,13 +1160,17 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 	lastY = ypos;
 
 	camera.ProcessMouseMovement(xoffset, yoffset);
+	cameraPath.addEvent(CameraPath::EVENT_MOUSE_MOVE, xoffset, yoffset);
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
+	if (replaying)
+		return;
 	camera.ProcessMouseScroll(yoffset);
+	cameraPath.addEvent(CameraPath::EVENT_SCROLL, 0.0f, (float)yoffset);
 	
 }
 
@@ -905,6 +1178,7 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 // ---------------------------------------------------
 unsigned int loadTexture(char const * path)
 {
+	PROFILE_ZONE("loadTexture");
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
 
@@ -923,6 +1197,7 @@ unsigned int loadTexture(char const * path)
 		glBindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
+		MemoryRegistry::instance().addTexture(textureID, path, format, width, height, 1, MemoryRegistry::mipCount(width, height));
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -951,11 +1226,12 @@ unsigned int loadTexture(char const * path)
 // -------------------------------------------------------
 unsigned int loadCubemap(vector<std::string> faces)
 {
+	PROFILE_ZONE("loadCubemap");
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-	int width, height, nrChannels;
+	int width = 0, height = 0, nrChannels;
 	for (unsigned int i = 0; i < faces.size(); i++)
 	{
 		unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
@@ -975,6 +1251,7 @@ unsigned int loadCubemap(vector<std::string> faces)
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	MemoryRegistry::instance().addTexture(textureID, faces.empty() ? "cubemap" : faces[0], GL_RGB, width, height, (int)faces.size());
 
 	return textureID;
 }
@@ -997,110 +1274,323 @@ void renderQuad()
 		// setup plane VAO
 		glGenVertexArrays(1, &quadVAO);
 		glGenBuffers(1, &quadVBO);
-		glBindVertexArray(quadVAO);
+		PipelineState::bindVertexArray(quadVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+		MemoryRegistry::instance().addBuffer(quadVBO, "screen_quad", MemoryRegistry::VERTEX_BUFFER, sizeof(quadVertices));
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
 		glEnableVertexAttribArray(1);
 		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 	}
-	glBindVertexArray(quadVAO);
+	PipelineState::bindVertexArray(quadVAO);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
 }
 
+// renderSphere() renders a UV sphere of radius 0.5, generated by buildSphere() on first use
+// -----------------------------------------------------------------------------------------
 unsigned int sphereVAO = 0;
+unsigned int sphereVBO = 0, sphereEBO = 0;
 unsigned int indexCount;
-void renderSphere()
+void buildSphere()
 {
-	if (sphereVAO == 0)
-	{
-		glGenVertexArrays(1, &sphereVAO);
+	glGenVertexArrays(1, &sphereVAO);
 
-		unsigned int vbo, ebo;
-		glGenBuffers(1, &vbo);
-		glGenBuffers(1, &ebo);
+	glGenBuffers(1, &sphereVBO);
+	glGenBuffers(1, &sphereEBO);
 
-		std::vector<glm::vec3> positions;
-		std::vector<glm::vec2> uv;
-		std::vector<glm::vec3> normals;
-		std::vector<unsigned int> indices;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uv;
+	std::vector<glm::vec3> normals;
+	std::vector<unsigned int> indices;
 
-		const unsigned int X_SEGMENTS = 64;
-		const unsigned int Y_SEGMENTS = 64;
-		const float PI = 3.14159265359;
-		for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
+	const unsigned int X_SEGMENTS = 64;
+	const unsigned int Y_SEGMENTS = 64;
+	static_assert((X_SEGMENTS + 1) * (Y_SEGMENTS + 1) <= 65536, "sphere indices are 16-bit");
+	const float PI = 3.14159265359;
+	for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
+	{
+		for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
 		{
-			for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
-			{
-				float xSegment = (float)x / (float)X_SEGMENTS;
-				float ySegment = (float)y / (float)Y_SEGMENTS;
-				float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI)/2;
-				float yPos = std::cos(ySegment * PI)/2;
-				float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI)/2;
-
-				positions.push_back(glm::vec3(xPos, yPos, zPos));
-				uv.push_back(glm::vec2(xSegment, ySegment));
-				normals.push_back(glm::vec3(xPos, yPos, zPos));
-			}
+			float xSegment = (float)x / (float)X_SEGMENTS;
+			float ySegment = (float)y / (float)Y_SEGMENTS;
+			float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI)/2;
+			float yPos = std::cos(ySegment * PI)/2;
+			float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI)/2;
+
+			positions.push_back(glm::vec3(xPos, yPos, zPos));
+			uv.push_back(glm::vec2(xSegment, ySegment));
+			normals.push_back(glm::vec3(xPos, yPos, zPos));
 		}
+	}
 
-		bool oddRow = false;
-		for (int y = 0; y < Y_SEGMENTS; ++y)
+	// two triangles per quad, wound the way the even rows of a strip would be
+	for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
+	{
+		for (unsigned int x = 0; x < X_SEGMENTS; ++x)
 		{
-			if (!oddRow) // even rows: y == 0, y == 2; and so on
-			{
-				for (int x = 0; x <= X_SEGMENTS; ++x)
-				{
-					indices.push_back(y       * (X_SEGMENTS + 1) + x);
-					indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-				}
-			}
-			else
-			{
-				for (int x = X_SEGMENTS; x >= 0; --x)
-				{
-					indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-					indices.push_back(y       * (X_SEGMENTS + 1) + x);
-				}
-			}
-			oddRow = !oddRow;
+			unsigned int top = y * (X_SEGMENTS + 1) + x;
+			unsigned int bottom = (y + 1) * (X_SEGMENTS + 1) + x;
+			indices.push_back(top);
+			indices.push_back(bottom);
+			indices.push_back(top + 1);
+			indices.push_back(top + 1);
+			indices.push_back(bottom);
+			indices.push_back(bottom + 1);
 		}
-		indexCount = indices.size();
+	}
+	if (MeshOptimizer::enabled())
+	{
+		MeshOptimizer::CacheStats before = MeshOptimizer::analyze(indices, positions.size());
+		MeshOptimizer::optimizeVertexCache(indices, positions.size());
+		MeshOptimizer::optimizeOverdraw(indices, &positions[0].x, 3, positions.size());
+		size_t keptCount = 0;
+		std::vector<unsigned int> remap = MeshOptimizer::optimizeVertexFetch(indices, positions.size(), keptCount);
+		MeshOptimizer::remapVertices(positions, 1, remap, keptCount);
+		MeshOptimizer::remapVertices(uv, 1, remap, keptCount);
+		MeshOptimizer::remapVertices(normals, 1, remap, keptCount);
+		MeshOptimizer::log("sphere", before, MeshOptimizer::analyze(indices, positions.size()));
+	}
+	indexCount = indices.size();
+	std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
 
-		std::vector<float> data;
-		for (int i = 0; i < positions.size(); ++i)
+	std::vector<float> data;
+	for (int i = 0; i < positions.size(); ++i)
+	{
+		data.push_back(positions[i].x);
+		data.push_back(positions[i].y);
+		data.push_back(positions[i].z);
+		if (uv.size() > 0)
 		{
-			data.push_back(positions[i].x);
-			data.push_back(positions[i].y);
-			data.push_back(positions[i].z);
-			if (uv.size() > 0)
-			{
-				data.push_back(uv[i].x);
-				data.push_back(uv[i].y);
-			}
-			if (normals.size() > 0)
-			{
-				data.push_back(normals[i].x);
-				data.push_back(normals[i].y);
-				data.push_back(normals[i].z);
-			}
+			data.push_back(uv[i].x);
+			data.push_back(uv[i].y);
+		}
+		if (normals.size() > 0)
+		{
+			data.push_back(normals[i].x);
+			data.push_back(normals[i].y);
+			data.push_back(normals[i].z);
 		}
-		glBindVertexArray(sphereVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-		float stride = (3 + 2 + 3) * sizeof(float);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(5 * sizeof(float)));
 	}
+	PipelineState::bindVertexArray(sphereVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+	glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), &shortIndices[0], GL_STATIC_DRAW);
+	MemoryRegistry::instance().addBuffer(sphereVBO, "sphere", MemoryRegistry::VERTEX_BUFFER, data.size() * sizeof(float));
+	MemoryRegistry::instance().addBuffer(sphereEBO, "sphere", MemoryRegistry::INDEX_BUFFER, shortIndices.size() * sizeof(uint16_t));
+	float stride = (3 + 2 + 3) * sizeof(float);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(5 * sizeof(float)));
+}
 
-	glBindVertexArray(sphereVAO);
-	glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
-}
\ No newline at end of file
+void renderSphere()
+{
+	if (sphereVAO == 0)
+		buildSphere();
+
+	PipelineState::bindVertexArray(sphereVAO);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
+}
+
+// deletes the sphere's buffers; the next renderSphere() builds it again
+void releaseSphere()
+{
+	if (sphereVAO == 0)
+		return;
+	MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_BUFFER, sphereVBO);
+	MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_BUFFER, sphereEBO);
+	glDeleteBuffers(1, &sphereVBO);
+	glDeleteBuffers(1, &sphereEBO);
+	glDeleteVertexArrays(1, &sphereVAO);
+	sphereVAO = sphereVBO = sphereEBO = 0;
+	PipelineState::invalidate(); // the deleted VAO's name may be handed out again
+}
+
+// shininess and point light falloff as compile-time constants (STATIC_SHININESS, STATIC_ATTENUATION)
+// ---------------------------------------------------------------------------------------------
+Specialization staticMaterialConstants()
+{
+	Specialization constants;
+	constants.set("SHININESS", MATERIAL_SHININESS).set("ATTENUATION", POINT_LIGHT_FALLOFF);
+	return constants;
+}
+
+// CPU-side micro-benchmarks (--micro-bench). GL work is finished inside the timed region where the
+// case measures loading/uploading, and outside of it where only submission cost is of interest.
+// ---------------------------------------------------------------------------------------------
+int runMicroBenchmarks(const RunOptions &options)
+{
+	MicroBench bench(options.benchWarmup, options.benchRepetitions, options.benchFilter);
+	unsigned int texture = 0;
+	std::function<void()> deleteTexture = [&] {
+		glDeleteTextures(1, &texture);
+		MemoryRegistry::instance().remove(MemoryRegistry::RESOURCE_TEXTURE, texture);
+	};
+	vector<std::string> faces
+	{
+		"./texture/skybox/right.jpg",
+		"./texture/skybox/left.jpg",
+		"./texture/skybox/top.jpg",
+		"./texture/skybox/bottom.jpg",
+		"./texture/skybox/front.jpg",
+		"./texture/skybox/back.jpg"
+	};
+
+	// Assimp import versus the memory-mapped cache entry the import writes. Each case switches the cache
+	// once in its setup, and it stays that way for all of its repetitions; --mesh-cache is restored after
+	// the run. The model outlives the timed body so its GL objects can be released untimed.
+	std::unique_ptr<Model> loadedModel;
+	std::function<void()> releaseModel = [&] {
+		loadedModel->release();
+		loadedModel.reset();
+	};
+	bench.add("model_load_globe_sphere", [&] {
+		loadedModel.reset(new Model("./Model/globe-sphere.obj"));
+		glFinish();
+	}, 1, [] { MeshCache::disable(); }, releaseModel);
+	bench.add("model_load_globe_sphere_cached", [&] {
+		loadedModel.reset(new Model("./Model/globe-sphere.obj"));
+		glFinish();
+	}, 1, [&] {
+		MeshCache::init(options.meshCacheDir);
+		Model warm("./Model/globe-sphere.obj"); // writes the entry if there is none yet
+		warm.release();
+	}, releaseModel);
+	bench.add("texture_from_file", [&] {
+		texture = TextureFromFile("container2.png", "./texture");
+		glFinish();
+	}, 1, nullptr, deleteTexture);
+	bench.add("load_texture", [&] {
+		texture = loadTexture("./texture/container2.png");
+		glFinish();
+	}, 1, nullptr, deleteTexture);
+	bench.add("load_cubemap", [&] {
+		texture = loadCubemap(faces);
+		glFinish();
+	}, 1, nullptr, deleteTexture);
+	bench.add("sphere_generate", [] {
+		buildSphere();
+		glFinish();
+	}, 1, nullptr, releaseSphere);
+
+	unsigned int program = 0;
+	bench.add("shader_compile_link_pbr", [&] {
+		Shader shader("./shaders/vertexshader/CT_brdf.vs", "./shaders/fragmentshader/CT_brdf.fs");
+		shader.finish();
+		program = shader.ID;
+		glFinish();
+	}, 1, nullptr, [&] { glDeleteProgram(program); });
+
+	Camera benchCamera(glm::vec3(0.0f, 0.0f, 3.0f));
+	glm::mat4 sink(0.0f);
+	bench.add("camera_get_view_matrix", [&] {
+		sink += benchCamera.GetViewMatrix();
+	}, 10000);
+	float yaw = YAW;
+	bench.add("camera_update_vectors", [&] {
+		yaw += 0.01f;
+		benchCamera.SetPose(benchCamera.Position, yaw, PITCH);
+	}, 10000);
+
+	// the benches below use the variant the scene draws the globe with
+	ShaderFamily benchMultiLight("./shaders/vertexshader/multi_light_material.vs", "./shaders/fragmentshader/multi_light_material.fs",
+		{ "DIRECTIONAL_LIGHT", "POINT_LIGHTS", "SPOT_LIGHT", "PHONG_SPECULAR" });
+	unsigned int litMask = MULTI_LIGHT_DIRECTIONAL | MULTI_LIGHT_POINT;
+
+	// Mesh::Draw submission: the model and shader are set up once, the GPU is drained between repetitions
+	std::unique_ptr<Model> drawModel;
+	Shader *drawShader = nullptr;
+	bench.add("mesh_draw_submission", [&] {
+		drawModel->Draw(*drawShader);
+	}, 100, [&] {
+		drawModel.reset(new Model("./Model/globe-sphere.obj"));
+		drawShader = &benchMultiLight.variant(litMask, staticMaterialConstants());
+		drawShader->use();
+		PipelineState::invalidate(); // loading the model bound textures and VAOs directly
+	}, [] { glFinish(); });
+
+	// uniform upload through the name table versus a handle resolved once
+	Shader *uniformShader = nullptr;
+	std::function<void()> useUniformShader = [&] {
+		uniformShader = &benchMultiLight.variant(litMask, staticMaterialConstants());
+		uniformShader->use();
+	};
+	// "model" is a plain uniform; the light uniforms live in the Lights block
+	UniformHandle<glm::mat4> modelHandle;
+	glm::mat4 benchModel(1.0f);
+	bench.add("uniform_set_by_name", [&] {
+		benchModel[3][0] += 0.001f; // a changing value, so every call uploads
+		uniformShader->setMat4("model", benchModel);
+	}, 10000, useUniformShader, [] { glFinish(); });
+	bench.add("uniform_set_by_handle", [&] {
+		benchModel[3][0] += 0.001f;
+		uniformShader->set(modelHandle, benchModel);
+	}, 10000, [&] {
+		useUniformShader();
+		modelHandle = uniformShader->uniform<glm::mat4>("model");
+	}, [] { glFinish(); });
+
+	// fragment cost of the lit globe with shininess and falloff read from uniforms versus baked in.
+	// The globe fills the viewport and is drawn without depth test, so every draw shades every pixel;
+	// glFinish is inside the timed region, so the wall time is dominated by the GPU.
+	std::unique_ptr<FrameUniforms> benchUniforms;
+	Shader *fragmentShader = nullptr;
+	std::function<void(Shader&)> setupFragmentBench = [&](Shader &shader) {
+		if (!drawModel)
+			drawModel.reset(new Model("./Model/globe-sphere.obj"));
+		PipelineState::invalidate();
+		if (!benchUniforms)
+		{
+			benchUniforms.reset(new FrameUniforms());
+			glm::vec3 eye(0.0f, 0.0f, 3.0f);
+			benchUniforms->setCamera(glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f), glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), eye);
+			benchUniforms->lights.dirLight.direction = glm::vec3(0.2f, 1.0f, -0.3f);
+			benchUniforms->lights.dirLight.diffuse = glm::vec3(0.4f);
+			benchUniforms->lights.dirLight.specular = glm::vec3(0.5f);
+			for (int i = 0; i < NR_POINT_LIGHTS; i++)
+			{
+				PointLightStd140 &light = benchUniforms->lights.pointLights[i];
+				light.position = glm::vec3(i == 0 ? 3.0f : -3.0f, 1.5f, 2.0f);
+				light.diffuse = glm::vec3(1.0f);
+				light.specular = glm::vec3(1.0f);
+				light.constant = POINT_LIGHT_FALLOFF.x;
+				light.linear = POINT_LIGHT_FALLOFF.y;
+				light.quadratic = POINT_LIGHT_FALLOFF.z;
+			}
+			benchUniforms->upload();
+		}
+		fragmentShader = &shader;
+		shader.use();
+		shader.setInt("material.diffuse", 0);
+		shader.setInt("material.specular", 1);
+		shader.setFloat("material.shininess", MATERIAL_SHININESS); // ignored by the specialized variant
+		shader.setMat4("model", glm::scale(glm::mat4(1.0f), glm::vec3(4.0f)));
+		glDisable(GL_DEPTH_TEST); // stays off for every repetition; enabled again after the run
+	};
+	std::function<void()> drawFragmentBench = [&] {
+		for (int i = 0; i < 20; i++)
+			drawModel->Draw(*fragmentShader);
+		glFinish();
+	};
+	bench.add("fragment_multi_light_generic", drawFragmentBench, 1, [&] {
+		setupFragmentBench(benchMultiLight.variant(litMask));
+	});
+	bench.add("fragment_multi_light_specialized", drawFragmentBench, 1, [&] {
+		setupFragmentBench(benchMultiLight.variant(litMask, staticMaterialConstants()));
+	});
+
+	bench.run();
+	glEnable(GL_DEPTH_TEST);
+	if (options.meshCache)
+		MeshCache::init(options.meshCacheDir);
+	else
+		MeshCache::disable();
+	if (sink[0][0] == 1.2345f)
+		std::cout << "" << std::flush; // keeps the view matrix loop from being optimized away
+	return bench.writeJson(options.benchJsonPath) ? 0 : 1;
+}
@@ -1,4 +1,7 @@
 #version 330 core
+// variant features, injected by ShaderFamily: DIRECTIONAL_LIGHT, POINT_LIGHTS, SPOT_LIGHT, PHONG_SPECULAR,
+// and the specialization constants STATIC_SHININESS and STATIC_ATTENUATION
+#inject
 out vec4 FragColor;
 
 struct Material {
@@ -7,25 +10,15 @@ struct Material {
     float shininess;
 }; 
 
-struct DirLight {
-    vec3 direction;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+// parameters a material may bake in as compile-time constants
+#ifdef STATIC_SHININESS
+#define SHININESS STATIC_SHININESS
+#else
+#define SHININESS material.shininess
+#endif
 
-struct PointLight {
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+#include "lights.glsl"
+#include "lighting.glsl"
 
 struct SpotLight {
     vec3 position;
@@ -42,15 +35,12 @@ struct SpotLight {
     vec3 specular;       
 };
 
-#define NR_POINT_LIGHTS 2
-
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+#include "camera.glsl"
+
 uniform SpotLight spotLight;
 uniform Material material;
 
@@ -63,27 +53,30 @@ void main()
 {    
     // properties
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(cameraPosition - FragPos);
    
     // == =====================================================
     // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
     // For each phase, a calculate function is defined that calculates the corresponding color
-    // per lamp. In the main() function we take all the calculated colors and sum them up for
-    // this fragment's final color.
+    // per lamp. Each phase is compiled in only when its variant feature is defined, and in
+    // the main() function we sum up the colors of the phases present.
     // == =====================================================
+    vec3 result = vec3(0.0);
+#ifdef DIRECTIONAL_LIGHT
     // phase 1: directional lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    result += CalcDirLight(dirLight, norm, viewDir);
+#endif
+#ifdef POINT_LIGHTS
     // phase 2: point lights
 	for(int i = 0; i < NR_POINT_LIGHTS; i++)
 		{
 		result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
 		}
+#endif
+#ifdef SPOT_LIGHT
     // phase 3: spot light
-  //  result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
-    
-	
-	//FragColor = vec4(1.0,1.0,1.0, 1.0);
-	//result+=vec3(1.0,1.0,1.0);
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
+#endif
     FragColor = vec4(result, 1.0);
 }
 
@@ -94,14 +87,7 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-	//Phong
-    //vec3 reflectDir = reflect(-lightDir, normal);
-    //float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-	
-	//Blinn
-	vec3 halfwayDir = normalize(lightDir + viewDir);  
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
-	
+    float spec = specularFactor(normal, lightDir, viewDir, SHININESS);
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
     vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
@@ -116,18 +102,14 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-	
-	//Phong
-    //vec3 reflectDir = reflect(-lightDir, normal);
-    //float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-	
-	//Blinn
-	vec3 halfwayDir = normalize(lightDir + viewDir);  
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
-	
+    float spec = specularFactor(normal, lightDir, viewDir, SHININESS);
     // attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+#ifdef STATIC_ATTENUATION
+    vec3 falloff = STATIC_ATTENUATION; // constant, linear, quadratic
+#else
+    vec3 falloff = vec3(light.constant, light.linear, light.quadratic);
+#endif
+    float attenuation = lightAttenuation(falloff.x, falloff.y, falloff.z, length(light.position - fragPos));
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
     vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
@@ -145,17 +127,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-	//Phong
-    //vec3 reflectDir = reflect(-lightDir, normal);
-    //float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-	
-	//Blinn
-	vec3 halfwayDir = normalize(lightDir + viewDir);  
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
-	
+    float spec = specularFactor(normal, lightDir, viewDir, SHININESS);
     // attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    float attenuation = lightAttenuation(light.constant, light.linear, light.quadratic, length(light.position - fragPos));
     // spotlight intensity
     float theta = dot(lightDir, normalize(-light.direction)); 
     float epsilon = light.cutOff - light.outerCutOff;
@@ -168,4 +142,4 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
-}
\ No newline at end of file
+}
@@ -1,4 +1,7 @@
 #version 330 core
+#define PHONG_SPECULAR
+#include "lighting.glsl"
+
 out vec4 FragColor;
 
 in vec3 Normal;  
@@ -24,8 +27,7 @@ void main()
     // specular
     float specularStrength = 0.95;
     vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);  
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    float spec = specularFactor(norm, lightDir, viewDir, 32.0);
     vec3 specular = specularStrength * spec * lightColor;  
         
     vec3 result = (ambient + diffuse + specular) * objectColor;
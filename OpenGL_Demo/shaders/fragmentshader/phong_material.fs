@@ -1,4 +1,7 @@
 #version 330 core
+#define PHONG_SPECULAR
+#include "lighting.glsl"
+
 out vec4 FragColor;
 
 struct Material {
@@ -36,8 +39,7 @@ void main()
     
     // specular
     vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);  
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = specularFactor(norm, lightDir, viewDir, material.shininess);
     vec3 specular = light.specular * (spec * material.specular);  
         
     vec3 result = ambient + diffuse + specular;
@@ -0,0 +1,7 @@
+// per-frame camera constants, shared by all programs (binding point 0, see FrameUniforms.h)
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cameraPosition;
+};
@@ -0,0 +1,19 @@
+// lighting terms shared by the Phong family of shaders
+
+// specular factor for light arriving along lightDir: Blinn-Phong, or Phong when PHONG_SPECULAR is defined
+float specularFactor(vec3 normal, vec3 lightDir, vec3 viewDir, float shininess)
+{
+#ifdef PHONG_SPECULAR
+    vec3 reflectDir = reflect(-lightDir, normal);
+    return pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+#else
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    return pow(max(dot(normal, halfwayDir), 0.0), shininess);
+#endif
+}
+
+// distance falloff of a point or spot light
+float lightAttenuation(float constant, float linear, float quadratic, float distance)
+{
+    return 1.0 / (constant + linear * distance + quadratic * (distance * distance));
+}
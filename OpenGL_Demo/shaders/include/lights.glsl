@@ -0,0 +1,27 @@
+// light structs and the per-frame Lights block (binding point 1, see FrameUniforms.h).
+// NR_POINT_LIGHTS is injected by the application so it always matches the C++ mirror of the block.
+struct DirLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// members are ordered so each float fills the tail of the preceding vec3's std140 slot
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+    vec3 color; // radiance for the PBR shader
+};
+
+layout (std140) uniform Lights
+{
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+};
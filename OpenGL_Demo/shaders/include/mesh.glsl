@@ -0,0 +1,9 @@
+// Position decoding for meshes uploaded as PackedVertex (Mesh.h): offset in xyz, scale in w, read
+// from the mesh's vertex array. Float meshes and other vertex arrays leave attribute 5 disabled, which
+// reads as its default (0, 0, 0, 1) and passes the position through unchanged.
+layout (location = 5) in vec4 aPositionDequantize;
+
+vec3 meshPosition(vec3 position)
+{
+    return aPositionDequantize.xyz + position * aPositionDequantize.w;
+}
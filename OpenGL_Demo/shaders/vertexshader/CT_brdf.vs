@@ -7,10 +7,10 @@ out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
 
-uniform mat4 projection;
-uniform mat4 view;
 uniform mat4 model;
 
+#include "camera.glsl"
+
 void main()
 {
     TexCoords = aTexCoords;
@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
+
+out vec4 Color;
+
+uniform vec2 screenSize; // framebuffer size in pixels
+uniform float scale;     // HUD pixels to framebuffer pixels
+
+void main()
+{
+    // HUD coordinates start at the top left corner, y pointing down
+    vec2 pixel = aPos.xy * scale;
+    gl_Position = vec4(pixel.x / screenSize.x * 2.0 - 1.0, 1.0 - pixel.y / screenSize.y * 2.0, 0.0, 1.0);
+    Color = aColor;
+}
@@ -5,12 +5,14 @@ layout (location = 1) in vec3 aColor;
 
 uniform mat4 mvp;
 
+#include "mesh.glsl"
+
 out vec4 ourColor;
 
 
 void main()
 {
-	gl_Position= mvp*vec4(aPos,1.0);
+	gl_Position= mvp*vec4(meshPosition(aPos),1.0);
    // gl_Position = vec4(aPos, 1.0);
       ourColor = vec4(aColor,1.0);
  